@@ -0,0 +1,11 @@
+#ifndef BENCHMARKS_HPP
+#define BENCHMARKS_HPP
+
+/*
+	Timings of the library's hot paths, run with
+	Test --bench [name] [font.ttf]
+	instead of opening the window. Returns the exit code.
+*/
+int runBenchmarks(int argc, char* argv[]);
+
+#endif
@@ -1,218 +1,297 @@
-#include "App.hpp"
-#include <sfttf/Font.hpp>
-
-#ifdef _MSC_VER
-#define mysnprintf sprintf_s
-#else
-#define mysnprintf _snprintf
-#endif
-
-/*
-	Options:
-	ALT+K - toggle kerning
-	ALT+F - toggle fill
-	ALT+O - toggle outline
-	ALT+C - clear cache
-	UP - increase font size by 1 or 10 (if CTRL)
-	DOWN - decrease font size by 1 or 10 (if CTRL)
-	SHIFT+UP - increase font outline by 1 or 10 (if CTRL)
-	SHIFT+DOWN - decrease font outline by 1 or 10 (if CTRL)
-
-	Commands:
-	ALT+Q - quit
-	ESCAPE - quit
-	ALT+ENTER - toggle fullscreen
-*/
-
-App::App() : myDone(false),
-			 myFont(0),
-			 myFPS(0.0f),
-			 myAverageFPS(0.0f),
-			 myLastFPSUpdate(0.0f),
-			 myNumberOfFrames(0),
-			 myFrameTimes(0.0f),
-			 myFullscreen(false)
-{
-
-}
-
-void App::Initialize(int argc, char* argv[])
-{
-	createWindow();
-	if (!myFontManager.Initialize(&myWindow))
-		throw std::runtime_error("Failed to initialize font manager");
-
-	myFont = myFontManager.loadFont(argc == 2 ? argv[1] : "mona.ttf");
-	if (0 == myFont)
-		throw std::runtime_error("Failed to load font");
-
-	myFont->setOutline(true);
-	myFont->setFill(true);
-	myFont->setOutlineColor(sf::Color::White);
-	myFont->setColor(sf::Color::Blue);
-	myFont->setSize(72);
-	myFont->setOutlineSize(1);
-}
-
-void App::Run(int argc, char* argv[])
-{
-	Initialize(argc, argv);
-	while (!myDone)
-	{
-		Update();
-		Draw();
-		myWindow.Display();
-		handleEvents();
-
-		float Delta = myWindow.GetFrameTime();
-
-		myFrameTimes += Delta;
-		myLastFPSUpdate += Delta;
-		++myNumberOfFrames;
-		if (myLastFPSUpdate >= 1.0f)
-		{
-			myFPS = 1.0f / Delta;
-			myAverageFPS = myNumberOfFrames / myFrameTimes;
-			myLastFPSUpdate = 0.0f;
-		}
-	}
-}
-
-void App::handleEvents()
-{
-	sf::Event Event;
-	while (myWindow.GetEvent(Event))
-	{
-		switch (Event.Type)
-		{
-		case sf::Event::Closed:
-			Exit();
-			break;
-		case sf::Event::KeyPressed:
-			onKeyPressed(Event.Key.Code, Event.Key.Alt, Event.Key.Control, Event.Key.Shift);
-			break;
-		default:
-			break;
-		}
-	}
-}
-
-void App::Update()
-{
-
-}
-
-void App::Draw()
-{
-	static char Buffer[256];
-
-	myWindow.Clear();
-
-	static const char* s = "the quick brown fox jumps over the lazy dog";
-	float X = 5.0f;
-	float Y = 154.0f;
-	unsigned int Size = myFont->getSize();
-	for (int i = myFont->getSize(); ; ++i)
-	{
-		myFont->Push();
-		myFont->setSize(i);
-		myFont->drawString(s, X, Y);
-		myFont->Pop();
-		Y += i;
-		if (Y >= static_cast<float>(ScreenHeight))
-			break;
-	}
-
-	myFont->Push();
-	myFont->setSize(26);
-	myFont->setFill(true);
-	myFont->setOutline(false);
-	myFont->setColor(sf::Color::White);
-
-	mysnprintf(Buffer, sizeof(Buffer), "FPS: %.2f", myFPS);
-	myFont->drawString(Buffer, 5, 26);
-
-	mysnprintf(Buffer, sizeof(Buffer), "Avg FPS: %.2f", myAverageFPS);
-	myFont->drawString(Buffer, 5, 52);
-
-	mysnprintf(Buffer, sizeof(Buffer), "%dx%d", myWindow.GetInput().GetMouseX(), myWindow.GetInput().GetMouseY());
-	myFont->drawString(Buffer, 5, 78);
-
-	mysnprintf(Buffer, sizeof(Buffer), "Size: %d", Size);
-	myFont->drawString(Buffer, 5, 104);
-	myFont->Pop();
-}
-
-void App::onKeyPressed(sf::Key::Code Code, bool Alt, bool Control, bool Shift)
-{
-	unsigned int Increment = (Control) ? 10 : 1;
-	switch (Code)
-	{
-	case sf::Key::Escape:
-		Exit();
-		break;
-	case sf::Key::Up:
-		if (Shift)
-			myFont->setOutlineSize(myFont->getOutlineSize() + Increment);
-		else
-			myFont->setSize(myFont->getSize() + Increment);
-
-		break;
-	case sf::Key::Down:
-		if (Shift)
-			myFont->setOutlineSize(myFont->getOutlineSize() - Increment);
-		else
-			myFont->setSize(myFont->getSize() - Increment);
-
-		break;
-	case sf::Key::C:
-		if (Alt)
-			myFont->clearCache();
-
-		break;
-	case sf::Key::F:
-		if (Alt)
-			myFont->setFill(!myFont->getFill());
-
-		break;
-	case sf::Key::K:
-		if (Alt)
-			myFont->setKerning(!myFont->getKerning());
-
-		break;
-	case sf::Key::O:
-		if (Alt)
-			myFont->setOutline(!myFont->getOutline());
-
-		break;
-	case sf::Key::Q:
-		if (Alt)
-			Exit();
-
-		break;
-	case sf::Key::Return:
-		if (Alt)
-		{
-			myFullscreen = !myFullscreen;
-			createWindow();
-		}
-		break;
-	default:
-		break;
-	}
-}
-
-void App::createWindow()
-{
-	int Flags = sf::Style::Close;
-	if (myFullscreen)
-		Flags |= sf::Style::Fullscreen;
-
-	myWindow.Create(sf::VideoMode(ScreenWidth, ScreenHeight, 32), "sfttf Test", Flags);
-}
-
-void App::Exit()
-{
-	myWindow.Show(false);
-	myDone = true;
-}
+#include "App.hpp"
+#include <sfttf/DynamicText.hpp>
+#include <sfttf/Font.hpp>
+#include <sfttf/FontLoader.hpp>
+
+#ifdef _MSC_VER
+#define mysnprintf sprintf_s
+#else
+#define mysnprintf _snprintf
+#endif
+
+/*
+	Options:
+	ALT+K - toggle kerning
+	ALT+F - toggle fill
+	ALT+O - toggle outline
+	ALT+B - toggle combined fill/outline glyphs
+	ALT+D - toggle distance field glyphs
+	ALT+S - toggle subpixel positioning
+	ALT+A - toggle background glyph rendering
+	ALT+C - clear cache
+	UP - increase font size by 1 or 10 (if CTRL)
+	DOWN - decrease font size by 1 or 10 (if CTRL)
+	SHIFT+UP - increase font outline by 1 or 10 (if CTRL)
+	SHIFT+DOWN - decrease font outline by 1 or 10 (if CTRL)
+
+	Commands:
+	ALT+Q - quit
+	ESCAPE - quit
+	ALT+ENTER - toggle fullscreen
+*/
+
+App::App() : myDone(false),
+			 myFont(0),
+			 myFPS(0.0f),
+			 myAverageFPS(0.0f),
+			 myLastFPSUpdate(0.0f),
+			 myNumberOfFrames(0),
+			 myFrameTimes(0.0f),
+			 myFullscreen(false)
+{
+
+}
+
+App::~App()
+{
+	for (std::size_t i = 0; i < myStatus.size(); ++i)
+		delete myStatus[i];
+}
+
+void App::Initialize(int argc, char* argv[])
+{
+	createWindow();
+	if (!myFontManager.Initialize(&myWindow))
+		throw std::runtime_error("Failed to initialize font manager");
+
+	/*
+		Keep the window responsive while a large font loads.
+	*/
+	sfttf::FontLoader* Loader = myFontManager.loadFontAsync(argc == 2 ? argv[1] : "mona.ttf");
+	if (0 == Loader)
+		throw std::runtime_error("Failed to load font");
+
+	while (!myDone && !Loader->isDone())
+	{
+		/*
+			The font handle does not exist yet, so only closing is
+			handled here, the other events are dropped.
+		*/
+		sf::Event Event;
+		while (myWindow.GetEvent(Event))
+		{
+			if (sf::Event::Closed == Event.Type)
+				Exit();
+		}
+		myWindow.Clear();
+		myWindow.Display();
+	}
+	myFont = myFontManager.finishLoad(Loader);
+	if (myDone)
+		return;
+
+	if (0 == myFont)
+		throw std::runtime_error("Failed to load font");
+
+	myFont->setOutline(true);
+	myFont->setFill(true);
+	myFont->setOutlineColor(sf::Color::White);
+	myFont->setColor(sf::Color::Blue);
+	myFont->setSize(72);
+	myFont->setOutlineSize(1);
+	myFont->setPlaceholder('?');
+	myFontManager.setWorkerCount(2);
+
+	sfttf::FontManager::PrewarmJobList Jobs(1);
+	Jobs[0].Font = myFont;
+	Jobs[0].Sizes.push_back(26);
+	Jobs[0].Sizes.push_back(72);
+	Jobs[0].outlineSizes.push_back(1);
+	for (wchar_t c = 32; c < 127; ++c)
+		Jobs[0].Text += c;
+	myFontManager.prewarmCaches(Jobs);
+
+	myFont->Push();
+	myFont->setSize(26);
+	myFont->setFill(true);
+	myFont->setOutline(false);
+	myFont->setColor(sf::Color::White);
+	for (int i = 0; i < 5; ++i)
+	{
+		myStatus.push_back(new sfttf::DynamicText(*myFont, ""));
+		myStatus.back()->SetPosition(5.0f, 26.0f * (i + 1));
+	}
+	myFont->Pop();
+}
+
+void App::Run(int argc, char* argv[])
+{
+	Initialize(argc, argv);
+	while (!myDone)
+	{
+		Update();
+		Draw();
+		myWindow.Display();
+		handleEvents();
+
+		float Delta = myWindow.GetFrameTime();
+
+		myFrameTimes += Delta;
+		myLastFPSUpdate += Delta;
+		++myNumberOfFrames;
+		if (myLastFPSUpdate >= 1.0f)
+		{
+			myFPS = 1.0f / Delta;
+			myAverageFPS = myNumberOfFrames / myFrameTimes;
+			myLastFPSUpdate = 0.0f;
+		}
+	}
+}
+
+void App::handleEvents()
+{
+	sf::Event Event;
+	while (myWindow.GetEvent(Event))
+	{
+		switch (Event.Type)
+		{
+		case sf::Event::Closed:
+			Exit();
+			break;
+		case sf::Event::KeyPressed:
+			onKeyPressed(Event.Key.Code, Event.Key.Alt, Event.Key.Control, Event.Key.Shift);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+void App::Update()
+{
+
+}
+
+void App::Draw()
+{
+	static char Buffer[256];
+
+	myWindow.Clear();
+
+	static const char* s = "the quick brown fox jumps over the lazy dog";
+	float X = 5.0f;
+	float Y = 180.0f;
+	unsigned int Size = myFont->getSize();
+	for (int i = myFont->getSize(); ; ++i)
+	{
+		myFont->Push();
+		myFont->setSize(i);
+		myFont->drawString(s, X, Y);
+		myFont->Pop();
+		Y += i;
+		if (Y >= static_cast<float>(ScreenHeight))
+			break;
+	}
+
+	mysnprintf(Buffer, sizeof(Buffer), "FPS: %.2f", myFPS);
+	myStatus[0]->setString(Buffer);
+
+	mysnprintf(Buffer, sizeof(Buffer), "Avg FPS: %.2f", myAverageFPS);
+	myStatus[1]->setString(Buffer);
+
+	mysnprintf(Buffer, sizeof(Buffer), "%dx%d", myWindow.GetInput().GetMouseX(), myWindow.GetInput().GetMouseY());
+	myStatus[2]->setString(Buffer);
+
+	mysnprintf(Buffer, sizeof(Buffer), "Size: %d", Size);
+	myStatus[3]->setString(Buffer);
+
+	mysnprintf(Buffer, sizeof(Buffer), "Textures: %u KB", static_cast<unsigned int>(myFont->getTextureMemory() / 1024));
+	myStatus[4]->setString(Buffer);
+
+	for (std::size_t i = 0; i < myStatus.size(); ++i)
+		myWindow.Draw(*myStatus[i]);
+}
+
+void App::onKeyPressed(sf::Key::Code Code, bool Alt, bool Control, bool Shift)
+{
+	unsigned int Increment = (Control) ? 10 : 1;
+	switch (Code)
+	{
+	case sf::Key::Escape:
+		Exit();
+		break;
+	case sf::Key::Up:
+		if (Shift)
+			myFont->setOutlineSize(myFont->getOutlineSize() + Increment);
+		else
+			myFont->setSize(myFont->getSize() + Increment);
+
+		break;
+	case sf::Key::Down:
+		if (Shift)
+			myFont->setOutlineSize(myFont->getOutlineSize() - Increment);
+		else
+			myFont->setSize(myFont->getSize() - Increment);
+
+		break;
+	case sf::Key::A:
+		if (Alt)
+			myFont->setAsync(!myFont->getAsync());
+
+		break;
+	case sf::Key::B:
+		if (Alt)
+			myFont->setCombine(!myFont->getCombine());
+
+		break;
+	case sf::Key::C:
+		if (Alt)
+			myFont->clearCache();
+
+		break;
+	case sf::Key::D:
+		if (Alt)
+			myFont->setDistanceField(!myFont->getDistanceField());
+
+		break;
+	case sf::Key::F:
+		if (Alt)
+			myFont->setFill(!myFont->getFill());
+
+		break;
+	case sf::Key::K:
+		if (Alt)
+			myFont->setKerning(!myFont->getKerning());
+
+		break;
+	case sf::Key::O:
+		if (Alt)
+			myFont->setOutline(!myFont->getOutline());
+
+		break;
+	case sf::Key::Q:
+		if (Alt)
+			Exit();
+
+		break;
+	case sf::Key::S:
+		if (Alt)
+			myFont->setSubpixel(!myFont->getSubpixel());
+
+		break;
+	case sf::Key::Return:
+		if (Alt)
+		{
+			myFullscreen = !myFullscreen;
+			createWindow();
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void App::createWindow()
+{
+	int Flags = sf::Style::Close;
+	if (myFullscreen)
+		Flags |= sf::Style::Fullscreen;
+
+	myWindow.Create(sf::VideoMode(ScreenWidth, ScreenHeight, 32), "sfttf Test", Flags);
+}
+
+void App::Exit()
+{
+	myWindow.Show(false);
+	myDone = true;
+}
@@ -0,0 +1,361 @@
+#include "Benchmarks.hpp"
+#include <sfttf/Atomic.hpp>
+#include <sfttf/Font.hpp>
+#include <sfttf/Glyph.hpp>
+#include <sfttf/GlyphAtlas.hpp>
+#include <sfttf/GlyphTable.hpp>
+#include <sfttf/Reclaimer.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+#include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Sleep.hpp>
+#include <SFML/System/Thread.hpp>
+
+namespace
+{
+	/*
+		The lookups the Test app's sentence does, at sizes 8 to 67
+		with fill and outline cached for printable ASCII.
+		The multimap is how glyphs were cached before GlyphTable:
+		keyed by code point only, the sizes scanned.
+	*/
+	typedef std::multimap<unsigned int, sfttf::Glyph*> GlyphMultimap;
+
+	sfttf::Glyph* findInMultimap(const GlyphMultimap& Glyphs, unsigned int codePoint, int Size, int outlineSize)
+	{
+		std::pair<GlyphMultimap::const_iterator, GlyphMultimap::const_iterator> Range(Glyphs.equal_range(codePoint));
+		for (; Range.second != Range.first; ++Range.first)
+		{
+			sfttf::Glyph* g = Range.first->second;
+			if (g->Size == Size && g->outlineSize == outlineSize)
+				return g;
+		}
+		return 0;
+	}
+
+	void benchGlyphLookup()
+	{
+		const int firstSize = 8;
+		const int sizeCount = 60;
+		const unsigned int firstCodePoint = 32;
+		const unsigned int codePointCount = 96;
+		const int Passes = 5000;
+		static const char* s = "the quick brown fox jumps over the lazy dog";
+		const std::size_t Length = std::strlen(s);
+
+		std::vector<sfttf::Glyph> Glyphs(sizeCount * codePointCount * 2);
+		GlyphMultimap Fills;
+		GlyphMultimap Outlines;
+		sfttf::Reclaimer Retired;
+		sfttf::GlyphTable Table(Retired);
+		std::size_t i = 0;
+		for (int Size = firstSize; Size < firstSize + sizeCount; ++Size)
+		{
+			for (unsigned int codePoint = firstCodePoint; codePoint < firstCodePoint + codePointCount; ++codePoint)
+			{
+				for (int outlineSize = 0; outlineSize < 2; ++outlineSize)
+				{
+					sfttf::Glyph* g = &Glyphs[i++];
+					g->codePoint = codePoint;
+					g->Size = Size;
+					g->outlineSize = outlineSize;
+					(outlineSize ? Outlines : Fills).insert(GlyphMultimap::value_type(codePoint, g));
+					Table.Insert(sfttf::GlyphKey(codePoint, Size, outlineSize, false, 0), g);
+				}
+			}
+		}
+
+		std::vector<sfttf::Glyph*> multimapFound;
+		std::vector<sfttf::Glyph*> tableFound;
+		multimapFound.reserve(Length * 2);
+		tableFound.reserve(Length * 2);
+
+		sf::Clock Clock;
+		for (int Pass = 0; Pass < Passes; ++Pass)
+		{
+			const int Size = firstSize + Pass % sizeCount;
+			multimapFound.clear();
+			for (std::size_t c = 0; c < Length; ++c)
+			{
+				const unsigned int codePoint = static_cast<unsigned char>(s[c]);
+				multimapFound.push_back(findInMultimap(Fills, codePoint, Size, 0));
+				multimapFound.push_back(findInMultimap(Outlines, codePoint, Size, 1));
+			}
+		}
+		const float multimapTime = Clock.GetElapsedTime();
+
+		unsigned int Mismatches = 0;
+		Clock.Reset();
+		for (int Pass = 0; Pass < Passes; ++Pass)
+		{
+			const int Size = firstSize + Pass % sizeCount;
+			tableFound.clear();
+			for (std::size_t c = 0; c < Length; ++c)
+			{
+				const unsigned int codePoint = static_cast<unsigned char>(s[c]);
+				tableFound.push_back(Table.Find(sfttf::GlyphKey(codePoint, Size, 0, false, 0)));
+				tableFound.push_back(Table.Find(sfttf::GlyphKey(codePoint, Size, 1, false, 0)));
+			}
+		}
+		const float tableTime = Clock.GetElapsedTime();
+
+		/*
+			Both found the same glyphs (last pass).
+		*/
+		for (std::size_t c = 0; c < tableFound.size(); ++c)
+		{
+			if (tableFound[c] != multimapFound[c] || 0 == tableFound[c])
+				++Mismatches;
+		}
+
+		const double Lookups = static_cast<double>(Passes) * Length * 2;
+		printf("Glyph lookup, %d sizes x %u code points, fill and outline:\n", sizeCount, codePointCount);
+		printf("\tstd::multimap equal_range + scan: %.1f ns per lookup\n", multimapTime * 1e9 / Lookups);
+		printf("\tGlyphTable::Find: %.1f ns per lookup\n", tableTime * 1e9 / Lookups);
+		if (0 != Mismatches)
+			printf("\t%u lookups disagree\n", Mismatches);
+	}
+
+	double getMsPerMegapixel(float Seconds, unsigned int Pixels, int Passes)
+	{
+		return Seconds * 1e3 / (static_cast<double>(Pixels) * Passes / 1e6);
+	}
+
+	/*
+		Coverage going into the atlas, for 256 x 256 glyphs (CJK sized).
+		Rows of combined pages are converted by both converters, then
+		whole bitmaps go through Upload (which picks the converter itself).
+	*/
+	void benchGlyphAtlas()
+	{
+		const unsigned int Size = 256;
+		const int rowPasses = 4000;
+		const int uploadPasses = 2000;
+
+		std::vector<unsigned char> Coverage(Size * Size);
+		std::vector<unsigned char> Share(Size * Size);
+		std::vector<unsigned char> Mono((Size / 8) * Size);
+		for (std::size_t i = 0; i < Coverage.size(); ++i)
+		{
+			Coverage[i] = static_cast<unsigned char>(std::rand());
+			Share[i] = static_cast<unsigned char>(std::rand());
+		}
+		for (std::size_t i = 0; i < Mono.size(); ++i)
+			Mono[i] = static_cast<unsigned char>(std::rand());
+
+		std::vector<sf::Uint8> Converted(Size * Size * 2);
+		printf("Glyph atlas upload, %ux%u glyphs:\n", Size, Size);
+		const char* Names[2] = {"scalar", "vectorized"};
+		sfttf::GlyphAtlas::RowConverter Converters[2] = {sfttf::GlyphAtlas::getRowConverter(false), sfttf::GlyphAtlas::getRowConverter(true)};
+		for (int c = 0; c < 2; ++c)
+		{
+			if (1 == c && Converters[1] == Converters[0])
+			{
+				printf("\tno vectorized converter on this processor\n");
+				break;
+			}
+			sf::Clock Clock;
+			for (int Pass = 0; Pass < rowPasses; ++Pass)
+			{
+				for (unsigned int y = 0; y < Size; ++y)
+					Converters[c](&Coverage[y * Size], &Share[y * Size], &Converted[y * Size * 2], Size);
+			}
+			printf("\tcombined rows, %s: %.3f ms per megapixel\n", Names[c], getMsPerMegapixel(Clock.GetElapsedTime(), Size * Size, rowPasses));
+		}
+
+		sfttf::GlyphAtlas Atlas;
+		FT_Bitmap Bitmap;
+		std::memset(&Bitmap, 0, sizeof(Bitmap));
+		Bitmap.rows = Size;
+		Bitmap.width = Size;
+		Bitmap.num_grays = 256;
+
+		const char* modeNames[3] = {"gray", "gray + share", "mono"};
+		for (int Mode = 0; Mode < 3; ++Mode)
+		{
+			const bool Combined = (1 == Mode);
+			Bitmap.pixel_mode = (2 == Mode) ? FT_PIXEL_MODE_MONO : FT_PIXEL_MODE_GRAY;
+			Bitmap.pitch = (2 == Mode) ? Size / 8 : Size;
+			Bitmap.buffer = (2 == Mode) ? &Mono[0] : &Coverage[0];
+
+			unsigned int Page = 0;
+			sf::IntRect Rect;
+			if (!Atlas.Allocate(Size, Size, Combined, Page, Rect))
+				continue;
+
+			sf::Clock Clock;
+			for (int Pass = 0; Pass < uploadPasses; ++Pass)
+				Atlas.Upload(Page, Rect, Bitmap, Combined ? &Share[0] : 0);
+
+			printf("\tUpload, %s: %.3f ms per megapixel\n", modeNames[Mode], getMsPerMegapixel(Clock.GetElapsedTime(), Size * Size, uploadPasses));
+		}
+	}
+	/*
+		Measures Text over and over with its own font handle until
+		Stop is set, counting the widths that are not Width.
+	*/
+	class Reader : public sf::Thread
+	{
+	public:
+		Reader(sfttf::Font* theFont, const std::string& theText, long& theStop) : Font(theFont),
+																				  Text(theText),
+																				  Width(theFont->getStringWidth(theText)),
+																				  Reads(0),
+																				  Mismatches(0),
+																				  myStop(&theStop)
+		{}
+
+		sfttf::Font* Font;
+		std::string Text;
+		unsigned int Width;
+		long Reads;
+		long Mismatches;
+
+	private:
+		virtual void Run()
+		{
+			while (0 == sfttf::atomicLoad(*myStop))
+			{
+				for (int i = 0; i < 100; ++i)
+				{
+					if (Font->getStringWidth(Text) != Width)
+						++Mismatches;
+				}
+				Reads += 100;
+			}
+		}
+
+		long* myStop;
+	};
+
+	/*
+		Readers measure a cached string in thread-safe mode while this
+		thread keeps caching new sizes of another handle (clearing its
+		cache every 60 sizes), or sleeps.
+		The string is printable ASCII: kerning of other pairs is not known
+		without the lock, so text with them would measure under the lock.
+		The time per read is each reader's own.
+	*/
+	void benchContention(const char* Filename)
+	{
+		const float Seconds = 1.0f;
+		static const char* s = "The quick brown fox jumps over the lazy dog";
+		std::wstring insertText;
+		for (wchar_t c = 0x100; c < 0x180; ++c)
+			insertText += c;
+
+		/*
+			The atlas textures need the window's context.
+		*/
+		sf::RenderWindow Window;
+		Window.Create(sf::VideoMode(64, 64, 32), "sfttf Benchmark", sf::Style::Close);
+		Window.Show(false);
+		sfttf::FontManager Manager;
+		if (!Manager.Initialize(&Window))
+			return;
+
+		Manager.setThreadSafe(true);
+		sfttf::Font* Inserter = Manager.loadFont(Filename);
+		if (0 == Inserter)
+		{
+			printf("Thread contention: cannot load %s\n", Filename);
+			return;
+		}
+
+		printf("Thread contention, getStringWidth on a cached string:\n");
+		const unsigned int readerCounts[2] = {1, 4};
+		for (int r = 0; r < 2; ++r)
+		{
+			for (int Insert = 0; Insert < 2; ++Insert)
+			{
+				long Stop = 0;
+				std::vector<Reader*> Readers;
+				for (unsigned int i = 0; i < readerCounts[r]; ++i)
+				{
+					sfttf::Font* readerFont = Manager.loadFont(Filename);
+					readerFont->setSize(16 + i % 3);
+					readerFont->cacheString(s);
+					Readers.push_back(new Reader(readerFont, s, Stop));
+				}
+				for (std::size_t i = 0; i < Readers.size(); ++i)
+					Readers[i]->Launch();
+
+				sf::Clock Clock;
+				int Size = 30;
+				long Inserted = 0;
+				while (Clock.GetElapsedTime() < Seconds)
+				{
+					if (0 == Insert)
+					{
+						sf::Sleep(0.001f);
+						continue;
+					}
+					Inserter->setSize(Size++);
+					if (Size >= 90)
+					{
+						Size = 30;
+						Inserter->clearCache();
+					}
+					Inserter->cacheString(insertText);
+					Inserted += static_cast<long>(insertText.size());
+				}
+				sfttf::atomicStore(Stop, 1L);
+				const float Elapsed = Clock.GetElapsedTime();
+
+				long Reads = 0;
+				long Mismatches = 0;
+				for (std::size_t i = 0; i < Readers.size(); ++i)
+				{
+					Readers[i]->Wait();
+					Reads += Readers[i]->Reads;
+					Mismatches += Readers[i]->Mismatches;
+					Manager.unloadFont(Readers[i]->Font);
+					delete Readers[i];
+				}
+				printf("\t%u readers, inserter %s: %.2f us per read per reader, %ld reads, %ld glyphs inserted", readerCounts[r], Insert ? "on" : "off", Elapsed * 1e6 * readerCounts[r] / (Reads ? Reads : 1), Reads, Inserted);
+				if (0 != Mismatches)
+					printf(", %ld wrong widths", Mismatches);
+
+				printf("\n");
+			}
+		}
+	}
+}
+
+/*
+	Test --bench [name] [font.ttf]
+	runs the benchmark called name, or all of them.
+	Benchmarks that need a font use font.ttf, mona.ttf if not given.
+*/
+int runBenchmarks(int argc, char* argv[])
+{
+	const char* Name = (argc >= 1) ? argv[0] : "all";
+	const char* Filename = (argc >= 2) ? argv[1] : "mona.ttf";
+	const bool All = (0 == std::strcmp(Name, "all"));
+	bool Found = All;
+	if (All || 0 == std::strcmp(Name, "lookup"))
+	{
+		benchGlyphLookup();
+		Found = true;
+	}
+	if (All || 0 == std::strcmp(Name, "atlas"))
+	{
+		benchGlyphAtlas();
+		Found = true;
+	}
+	if (All || 0 == std::strcmp(Name, "threads"))
+	{
+		benchContention(Filename);
+		Found = true;
+	}
+	if (!Found)
+	{
+		printf("Unknown benchmark %s (lookup, atlas, threads, all)\n", Name);
+		return 1;
+	}
+	return 0;
+}
@@ -1,16 +1,21 @@
-#include "App.hpp"
-
-int main(int argc, char* argv[])
-{
-	try
-	{
-		App theApp;
-		theApp.Run(argc, argv);
-	}
-	catch (const std::exception& e)
-	{
-		printf("Exception: %s\n", e.what());
-		return 1;
-	}
-	return 0;
-}
+#include "App.hpp"
+#include "Benchmarks.hpp"
+#include <cstring>
+
+int main(int argc, char* argv[])
+{
+	if (argc >= 2 && 0 == std::strcmp(argv[1], "--bench"))
+		return runBenchmarks(argc - 2, argv + 2);
+
+	try
+	{
+		App theApp;
+		theApp.Run(argc, argv);
+	}
+	catch (const std::exception& e)
+	{
+		printf("Exception: %s\n", e.what());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,111 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#ifndef SFTTF_ATOMIC_HPP
+#define SFTTF_ATOMIC_HPP
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#pragma intrinsic(_InterlockedIncrement, _InterlockedDecrement, _InterlockedExchange, _ReadWriteBarrier)
+#endif
+
+namespace sfttf
+{
+
+/*
+	The few atomic operations needed to read glyphs without a lock
+	(see Reclaimer and GlyphTable), for Visual C++ and GCC.
+
+	atomicLoad and atomicStore work on pointers and longs. A load sees
+	everything written before the store of the value it reads.
+	atomicIncrement, atomicDecrement and memoryBarrier are full barriers.
+*/
+template <typename T>
+inline T atomicLoad(const T& Value)
+{
+#if defined(_MSC_VER)
+	/*
+		x86 loads are not reordered with later loads or stores,
+		the compiler only must not move them.
+	*/
+	const T Result = *static_cast<const volatile T*>(&Value);
+	_ReadWriteBarrier();
+	return Result;
+#elif defined(__ATOMIC_ACQUIRE)
+	return __atomic_load_n(&Value, __ATOMIC_ACQUIRE);
+#else
+	const T Result = *static_cast<const volatile T*>(&Value);
+	__sync_synchronize();
+	return Result;
+#endif
+}
+
+template <typename T>
+inline void atomicStore(T& Target, T Value)
+{
+#if defined(_MSC_VER)
+	_ReadWriteBarrier();
+	*static_cast<volatile T*>(&Target) = Value;
+#elif defined(__ATOMIC_RELEASE)
+	__atomic_store_n(&Target, Value, __ATOMIC_RELEASE);
+#else
+	__sync_synchronize();
+	*static_cast<volatile T*>(&Target) = Value;
+#endif
+}
+
+inline long atomicIncrement(long& Value)
+{
+#if defined(_MSC_VER)
+	return _InterlockedIncrement(&Value);
+#else
+	return __sync_add_and_fetch(&Value, 1);
+#endif
+}
+
+inline long atomicDecrement(long& Value)
+{
+#if defined(_MSC_VER)
+	return _InterlockedDecrement(&Value);
+#else
+	return __sync_sub_and_fetch(&Value, 1);
+#endif
+}
+
+inline void memoryBarrier()
+{
+#if defined(_MSC_VER)
+	long Barrier = 0;
+	_InterlockedExchange(&Barrier, 1);
+#else
+	__sync_synchronize();
+#endif
+}
+
+}
+
+#endif
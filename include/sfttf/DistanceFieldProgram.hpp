@@ -0,0 +1,73 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#ifndef SFTTF_DISTANCE_FIELD_PROGRAM_HPP
+#define SFTTF_DISTANCE_FIELD_PROGRAM_HPP
+
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/System/NonCopyable.hpp>
+
+namespace sfttf
+{
+
+/*
+	The GLSL program that draws distance field glyphs (see Font::setDistanceField).
+
+	The field is in the texture's alpha: 0.5 on the glyph's edge, more inside.
+	The fill is the vertex color, the outline a uniform, so a batch draws
+	one group of quads per outline color and width (see GlyphBatch).
+*/
+class DistanceFieldProgram : public sf::NonCopyable
+{
+public:
+	/*
+		The program, compiled the first time it is asked for.
+		Returns 0 if OpenGL 2.0 is not available or compiling failed.
+		Needs a current context.
+	*/
+	static const DistanceFieldProgram* getProgram();
+
+	/*
+		outlineWidth is in field units: the outline covers field values from
+		0.5 - outlineWidth to 0.5 + outlineWidth, like FreeType's stroker.
+	*/
+	void Bind(const sf::Color& outlineColor, float outlineWidth) const;
+	static void Unbind();
+
+private:
+	DistanceFieldProgram();
+
+	bool Load();
+
+	unsigned int myProgram;
+	int myOutlineColor;
+	int myOutlineWidth;
+};
+
+}
+
+#endif
@@ -0,0 +1,104 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#ifndef SFTTF_DYNAMIC_TEXT_HPP
+#define SFTTF_DYNAMIC_TEXT_HPP
+
+#include <sfttf/Font.hpp>
+#include <sfttf/GlyphBatch.hpp>
+#include <string>
+#include <vector>
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/Rect.hpp>
+
+namespace sfttf
+{
+
+/*
+	A DynamicText is like a TextRun, for text that changes often but only
+	a little at a time (counters, timers, coordinates, ...).
+
+	It keeps where each character was placed. When the string changes,
+	characters that did not change (and did not move) keep their placement,
+	only the others are looked up and placed again. Setting the same
+	string again costs nothing.
+
+	Like a TextRun, it takes the font's settings when it is created
+	(or in updateSettings) and is drawn with Window.Draw(Text) at its
+	position, the pen position on the baseline.
+
+	Its glyphs stay in the font's cache while it exists, like a TextRun's.
+
+	The font must stay loaded while the text exists.
+*/
+class DynamicText : public sf::Drawable
+{
+public:
+	DynamicText(Font& theFont, const std::string& s);
+	DynamicText(Font& theFont, const std::wstring& s);
+
+	void setString(const std::string& s);
+	void setString(const std::wstring& s);
+
+	/*
+		Take the font's current settings again.
+	*/
+	void updateSettings();
+
+	/*
+		Area covered by the glyphs, relative to the text's position.
+	*/
+	const sf::FloatRect& getBounds() const;
+
+protected:
+	virtual void Render(sf::RenderTarget& Target) const;
+
+private:
+	template <typename TIterator>
+	void setString(TIterator itCodePoint, const TIterator& itEnd);
+
+	void updateLayout() const;
+
+	Font* myFont;
+	Font::Settings mySettings;
+	std::vector<uint32_t> myText;
+
+	/*
+		The layout is updated on demand, which can happen in Render.
+		myLayoutText is the text myLayout was made for, myDirty is set
+		when the layout must be made again even if the text is the same.
+	*/
+	mutable std::vector<uint32_t> myLayoutText;
+	mutable Font::PlacedCharList myLayout;
+	mutable GlyphBatch myBatch;
+	mutable Font::LayoutGlyphs myGlyphs;
+	mutable bool myDirty;
+};
+
+}
+
+#endif
@@ -1,185 +1,456 @@
-/**********************************************************************
- Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
- All rights reserved.
-
- Redistribution and use in source and binary forms, with or without
- modification, are permitted provided that the following conditions
- are met:
-
- * Redistributions of source code must retain the above copyright
- notice, this list of conditions and the following disclaimer.
-
- * Redistributions in binary form must reproduce the above copyright
- notice, this list of conditions and the following disclaimer in the
- documentation and/or other materials provided with the distribution.
-
- THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
- "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
- LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
- A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
- OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
- SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
- LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
- DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
- THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
- (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
- OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-**********************************************************************/
-#ifndef SFTTF_FONT_HPP
-#define SFTTF_FONT_HPP
-
-#include <sfttf/FontManager.hpp>
-#include <map>
-#include <vector>
-#include FT_STROKER_H
-
-namespace sfttf
-{
-
-struct Glyph;
-typedef unsigned int uint32_t;
-
-class Font : public sf::NonCopyable
-{
-public:
-	bool cacheChar(uint32_t codePoint);
-	bool cacheString(const std::string& s);
-	bool cacheString(const std::wstring& s);
-
-	void clearCache();
-
-	void setFill(bool Fill);
-	void setOutline(bool Outline);
-	void setSize(int Size);
-	void setOutlineSize(int Size);
-
-	void setColor(const sf::Color& Color);
-	void setOutlineColor(const sf::Color& Color);
-
-	void setKerning(bool Kerning);
-
-	bool drawChar(uint32_t codePoint, float X, float Y);
-	bool drawString(const std::string& s, float X, float Y);
-	bool drawString(const std::wstring& s, float X, float Y);
-
-	unsigned int getCharWidth(uint32_t codePoint);
-	unsigned int getCharHeight(uint32_t codePoint);
-
-	unsigned int getStringWidth(const std::string& s);
-	unsigned int getStringWidth(const std::wstring& s);
-	unsigned int getStringHeight(const std::string& s);
-	unsigned int getStringHeight(const std::wstring& s);
-
-	bool getFill() const;
-	bool getOutline() const;
-
-	int getSize() const;
-	int getOutlineSize() const;
-
-	bool getKerning() const;
-
-	void Push();
-	void Pop();
-
-private:
-	/*
-	Quick helper class to insure FT_Done_Glyph is called on an FT_Glyph
-	*/
-	struct FreeGlyph
-	{
-		FreeGlyph(FT_Glyph* Glyph) : myGlyph(Glyph)
-		{}
-
-		~FreeGlyph()
-		{
-			if (0 != myGlyph)
-				FT_Done_Glyph(*myGlyph);
-		}
-
-	private:
-		FT_Glyph* myGlyph;
-	};
-	/*
-		All client-writeable settings.
-		They're in a separate struct so we can easily make a settings 'stack'.
-		See Push/Pop
-	*/
-	struct Settings
-	{
-		Settings() : Fill(true),
-					 Outline(false),
-					 Size(32),
-					 outlineSize(1),
-					 Kerning(true),
-					 Color(sf::Color::White),
-					 outlineColor(sf::Color::Blue)
-		{}
-		bool Fill;
-		bool Outline;
-		int Size;
-		int outlineSize;
-
-		bool Kerning;
-		sf::Color Color;
-		sf::Color outlineColor;
-	};
-	typedef std::multimap<uint32_t, Glyph*> GlyphCache;
-	typedef std::pair<GlyphCache::iterator, GlyphCache::iterator> GlyphRange;
-
-	typedef std::vector<Settings> SettingsStack;
-
-	Font(sf::RenderWindow* Window, FT_Library FreeType);
-	~Font();
-
-	bool Initialize(const std::string& Filename);
-	void Deinitialize();
-
-	bool updateSize();
-	void updateOutlineSize();
-
-	bool cacheGlyph(uint32_t codePoint);
-	bool isGlyphCached(uint32_t codePoint);
-	bool cacheGlyphOutline(uint32_t codePoint);
-	bool isGlyphOutlineCached(uint32_t codePoint);
-
-	Glyph* getGlyph(uint32_t codePoint);
-	Glyph* getGlyphOutline(uint32_t codePoint);
-
-	Glyph* drawChar(uint32_t codePoint, float& penX, float& penY, Glyph* previousGlyph);
-	void getKerning(Glyph* leftGlyph, Glyph* rightGlyph, int* offsetX, int* offsetY);
-
-	template <typename TIterator>
-	bool cacheString(TIterator itCodePoint, const TIterator& itEnd);
-
-	template <typename TIterator>
-	bool drawString(TIterator itCodePoint, const TIterator& itEnd, float X, float Y);
-
-	template <typename TIterator>
-	unsigned int getStringWidth(TIterator itCodePoint, const TIterator& itEnd);
-
-	template <typename TIterator>
-	unsigned int getStringHeight(TIterator itCodePoint, const TIterator& itEnd);
-
-	friend class FontManager;
-
-	sf::RenderWindow* myWindow;
-	FT_Library myFreeType;
-	FT_Face myFace;
-	FT_Stroker myStroker;
-
-	Settings mySettings;
-	SettingsStack mySettingsStack;
-
-	int myFreeTypeSize;
-
-	int myFreeTypeOutlineSize;
-
-	bool myHaveKerning;
-
-	GlyphCache myGlyphs;
-	GlyphCache myGlyphOutlines;
-};
-
-}
-
-#endif
+/**********************************************************************
+ Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions
+ are met:
+
+ * Redistributions of source code must retain the above copyright
+ notice, this list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright
+ notice, this list of conditions and the following disclaimer in the
+ documentation and/or other materials provided with the distribution.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#ifndef SFTTF_FONT_HPP
+#define SFTTF_FONT_HPP
+
+#include <sfttf/FontFace.hpp>
+#include <sfttf/FontManager.hpp>
+#include <sfttf/GlyphBatch.hpp>
+#include <sfttf/StringImageCache.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace sfttf
+{
+
+struct Glyph;
+class DynamicText;
+class Paragraph;
+class TextRun;
+
+/*
+	A Font is a handle to a loaded font.
+
+	Handles loaded from the same file share the font face and its glyph
+	cache (see FontFace), so cache operations (clearCache, budgets, pinning,
+	saveCache/loadCache) affect all of them.
+	Settings (size, colors, ...) belong to each handle.
+	A handle is used by one thread at a time, see FontManager::setThreadSafe.
+*/
+class Font : public sf::NonCopyable
+{
+public:
+	bool cacheChar(uint32_t codePoint);
+	bool cacheString(const std::string& s);
+	bool cacheString(const std::wstring& s);
+
+	void clearCache();
+
+	/*
+		Limit the memory used by this font's cached glyphs, in bytes.
+		0 (the default) means no limit.
+
+		When a new glyph takes the cache over the limit, the least recently
+		used glyphs are evicted. Glyphs used by the current call are never
+		evicted, so the limit can be exceeded by one string's worth.
+		Neither are the glyphs of existing TextRun, DynamicText and
+		Paragraph objects, which still count in the cache size.
+	*/
+	void setCacheBudget(std::size_t Bytes);
+	std::size_t getCacheBudget() const;
+	std::size_t getCacheSize() const;
+
+	/*
+		Bytes used by the glyph textures (shared with the other handles
+		of the font), once in RAM and once more in texture memory.
+		Textures are allocated in whole pages, so this is usually more
+		than the texture part of getCacheSize. Space left by evicted
+		glyphs is reused and pages left without glyphs are released,
+		but glyphs of very different sizes still leave pages part empty.
+	*/
+	std::size_t getTextureMemory() const;
+
+	/*
+		Cache and pin glyphs at the current settings.
+		Pinned glyphs are never evicted, clearCache still removes them.
+	*/
+	bool pinChar(uint32_t codePoint);
+	bool pinString(const std::string& s);
+	bool pinString(const std::wstring& s);
+	void unpinAll();
+
+	/*
+		Write every cached glyph to a file, so a later run can load them
+		with loadCache instead of rasterizing them again.
+
+		A cache file only loads into a font made from the same font file,
+		by the same FreeType version. Glyphs already cached are kept.
+		Files are written in the machine's byte order, and only load
+		on machines with the same.
+		A file that fails to load (corrupt, truncated) adds no glyphs.
+	*/
+	bool saveCache(const std::string& Filename);
+	bool loadCache(const std::string& Filename);
+
+	void setFill(bool Fill);
+	void setOutline(bool Outline);
+	void setSize(int Size);
+	void setOutlineSize(int Size);
+
+	void setColor(const sf::Color& Color);
+	void setOutlineColor(const sf::Color& Color);
+
+	void setKerning(bool Kerning);
+
+	/*
+		When drawing both fill and outline, use combined glyphs: one texture
+		area and one quad per character instead of two, with both colors
+		applied when drawn. On by default.
+
+		Only used when the fill and outline colors have the same alpha
+		and OpenGL supports it, separate glyphs are used otherwise.
+	*/
+	void setCombine(bool Combine);
+
+	/*
+		Draw from distance field glyphs: each character is rendered once
+		and drawn at any size and outline size, so the cache does not grow
+		with the number of sizes used. Off by default.
+
+		Edges are smooth but lose some detail at large sizes, and only
+		OpenGL 2.0 can draw them (bitmap glyphs are used otherwise).
+		drawCachedString always uses bitmap glyphs.
+	*/
+	void setDistanceField(bool DistanceField);
+
+	/*
+		Position glyphs to a fraction of a pixel: advances and kerning are
+		not rounded, so strings keep the width the font was designed with
+		instead of drifting by up to a pixel per character. Off by default.
+
+		Each character is rendered at a few horizontal offsets (cached like
+		separate glyphs), the closest one is drawn at a whole pixel.
+		Glyphs are only hinted vertically in this mode.
+		Not used with distance field glyphs, they are placed freely anyway.
+	*/
+	void setSubpixel(bool Subpixel);
+
+	/*
+		Render glyphs that are not cached yet on the font manager's
+		workers (see FontManager::setWorkerCount) instead of stalling
+		the frame that first draws them. Off by default.
+
+		Until a character's glyphs arrive, the placeholder character is
+		drawn in its place (nothing if it is 0, the default), and the
+		text moves once they do. cacheString queues its characters too.
+		Measuring, pinning and drawCachedString always wait for the glyphs.
+	*/
+	void setAsync(bool Async);
+	void setPlaceholder(uint32_t codePoint);
+
+	bool drawChar(uint32_t codePoint, float X, float Y);
+	bool drawString(const std::string& s, float X, float Y);
+	bool drawString(const std::wstring& s, float X, float Y);
+
+	/*
+		Draw s from an image of the whole string (fill, outline and kerning
+		included), made the first time s is drawn with the current settings.
+		Afterwards it costs a single quad, whatever the length of s.
+		X and Y are rounded to whole pixels.
+
+		Meant for text that never changes, every new string or settings
+		combination makes a new image. The images are kept per Font,
+		see setStringCacheBudget.
+	*/
+	bool drawCachedString(const std::string& s, float X, float Y);
+	bool drawCachedString(const std::wstring& s, float X, float Y);
+
+	/*
+		Limit the memory used by drawCachedString's images, in bytes.
+		The default is 1 MB, 0 means no limit.
+		clearCache also clears them.
+	*/
+	void setStringCacheBudget(std::size_t Bytes);
+	std::size_t getStringCacheBudget() const;
+	std::size_t getStringCacheSize() const;
+
+	/*
+		Measuring renders nothing: characters that are not cached are
+		only loaded for their metrics. These are kept in the glyph cache
+		without a texture, counted in its size and evicted like glyphs,
+		until the character is rendered.
+	*/
+	unsigned int getCharWidth(uint32_t codePoint);
+	unsigned int getCharHeight(uint32_t codePoint);
+
+	/*
+		In thread-safe mode (see FontManager::setThreadSafe), strings
+		whose glyphs are all cached or measured are measured without the lock.
+		Kerning is only known that way for printable ASCII pairs.
+	*/
+	unsigned int getStringWidth(const std::string& s);
+	unsigned int getStringWidth(const std::wstring& s);
+	unsigned int getStringHeight(const std::string& s);
+	unsigned int getStringHeight(const std::wstring& s);
+
+	/*
+		getStringWidth and getStringHeight in one pass, with how far the
+		string reaches above (Ascent) and below (Descent) the baseline.
+		Descent is positive below it.
+	*/
+	struct StringBounds
+	{
+		StringBounds() : Width(0),
+						 Height(0),
+						 Ascent(0),
+						 Descent(0)
+		{}
+		unsigned int Width;
+		unsigned int Height;
+		int Ascent;
+		int Descent;
+	};
+	StringBounds getStringBounds(const std::string& s);
+	StringBounds getStringBounds(const std::wstring& s);
+
+	bool getFill() const;
+	bool getOutline() const;
+
+	int getSize() const;
+	int getOutlineSize() const;
+
+	bool getKerning() const;
+	bool getCombine() const;
+	bool getDistanceField() const;
+	bool getSubpixel() const;
+	bool getAsync() const;
+	uint32_t getPlaceholder() const;
+
+	void Push();
+	void Pop();
+
+private:
+	/*
+		All client-writeable settings.
+		They're in a separate struct so we can easily make a settings 'stack'.
+		See Push/Pop
+	*/
+	struct Settings
+	{
+		Settings() : Fill(true),
+					 Outline(false),
+					 Size(32),
+					 outlineSize(1),
+					 Kerning(true),
+					 Combine(true),
+					 DistanceField(false),
+					 Subpixel(false),
+					 Async(false),
+					 Placeholder(0),
+					 Color(sf::Color::White),
+					 outlineColor(sf::Color::Blue)
+		{}
+		bool Fill;
+		bool Outline;
+		int Size;
+		int outlineSize;
+
+		bool Kerning;
+		bool Combine;
+		bool DistanceField;
+		bool Subpixel;
+		bool Async;
+		uint32_t Placeholder;
+		sf::Color Color;
+		sf::Color outlineColor;
+	};
+	typedef std::vector<Settings> SettingsStack;
+
+	/*
+		A character placed by placeChar.
+		Its glyphs are drawn from X, Y, the pen being at penX, penY before
+		the character (kerning not applied) and at nextX, nextY after it.
+	*/
+	struct PlacedChar
+	{
+		float penX;
+		float penY;
+		Glyph* filledGlyph;
+		Glyph* outlinedGlyph;
+		float X;
+		float Y;
+		float nextX;
+		float nextY;
+	};
+	typedef std::vector<PlacedChar> PlacedCharList;
+
+	/*
+		A line of a paragraph (see Paragraph). The characters from Start
+		to Next are on it, the first Length of them are drawn (not the
+		spaces it was broken at or the new line ending it).
+		Width is from the pen's start to the right of the last glyph drawn.
+	*/
+	struct Line
+	{
+		std::size_t Start;
+		std::size_t Length;
+		std::size_t Next;
+		float Width;
+	};
+	typedef std::vector<Line> LineList;
+
+	/*
+		The glyphs a text drawable's layout placed. They are held in the
+		cache (see FontFace::holdGlyph), so budgets do not evict them,
+		until the drawable is laid out again or destroyed. Only clearCache
+		removes them, which makes the layout out of date.
+		A layout made with placeholders for glyphs the workers were still
+		rendering is also out of date once glyphs arrive.
+		A copy holds nothing and is out of date, so a copied drawable is
+		laid out again.
+	*/
+	class LayoutGlyphs
+	{
+	public:
+		explicit LayoutGlyphs(Font& theFont);
+		LayoutGlyphs(const LayoutGlyphs& Other);
+		~LayoutGlyphs();
+		LayoutGlyphs& operator=(const LayoutGlyphs& Other);
+
+		/*
+			Called with the manager locked, around the layout.
+			Kept tells whether the layout kept part of the previous one.
+		*/
+		void beginLayout();
+		void endLayout(const std::vector<Glyph*>& Glyphs, bool Kept);
+		void endLayout(const PlacedCharList& Layout, bool Kept);
+		bool isCurrent() const;
+
+	private:
+		void Release();
+
+		Font* myFont;
+		std::vector<Glyph*> myHeld;
+		unsigned int myClearCount;
+		unsigned int myArrivalCount;
+		bool myCurrent;
+		bool myIncomplete;
+	};
+
+	/*
+		For the text drawables, which lock the manager
+		the same way the public calls do.
+	*/
+	typedef FontManager::UseLock UseLock;
+
+	Font(FontManager* Manager, sf::RenderWindow* Window, FontFace* Face);
+	~Font();
+
+	bool cacheChar(uint32_t codePoint, Glyph*& filledGlyph, Glyph*& outlinedGlyph);
+	bool cacheChar(uint32_t codePoint, Glyph*& filledGlyph, Glyph*& outlinedGlyph, int Phase, bool Async);
+	bool getGlyphKeys(uint32_t codePoint, int Phase, GlyphKey* Keys, int& keyCount) const;
+	bool addPhaseKeys(uint32_t codePoint, std::vector<GlyphKey>& Keys) const;
+	bool cachePhases(uint32_t codePoint, bool Pin);
+	bool findChar(uint32_t codePoint, Glyph*& filledGlyph, Glyph*& outlinedGlyph) const;
+	Glyph* measureChar(uint32_t codePoint);
+	bool useCombined() const;
+	bool useDistanceField() const;
+	bool useSubpixel() const;
+	int getPhase(float X, float& wholeX) const;
+	float getScale(const Glyph* g) const;
+	float getAdvance(const Glyph* g) const;
+	void batchGlyph(GlyphBatch& Batch, Glyph* g, float X, float Y, const sf::Color& Color);
+
+	Glyph* batchChar(GlyphBatch& Batch, uint32_t codePoint, float& penX, float& penY, Glyph* previousGlyph);
+	bool placeChar(uint32_t codePoint, float& penX, float& penY, Glyph* previousGlyph, PlacedChar& Placed);
+	void batchPlaced(GlyphBatch& Batch, const PlacedChar& Placed);
+	void getKerning(Glyph* leftGlyph, Glyph* rightGlyph, float* offsetX, float* offsetY);
+	bool findKerning(const Glyph* leftGlyph, const Glyph* rightGlyph, float* offsetX) const;
+
+	void layoutRun(const Settings& runSettings, const std::vector<uint32_t>& Text, GlyphBatch& Batch, std::vector<Glyph*>* Glyphs);
+	void updateRun(const Settings& runSettings, const std::vector<uint32_t>& oldText, const std::vector<uint32_t>& Text, PlacedCharList& Layout, GlyphBatch& Batch);
+	void breakLines(const Settings& runSettings, const std::vector<uint32_t>& Text, float Width, std::size_t firstLine, LineList& Lines);
+	bool breakLine(const std::vector<uint32_t>& Text, float Width, Line& theLine);
+	void layoutLines(const Settings& runSettings, const std::vector<uint32_t>& Text, const LineList& Lines, std::size_t firstLine, float boxWidth, float Align, float lineSpacing, PlacedCharList& Layout, GlyphBatch& Batch);
+	void getLineMetrics(const Settings& runSettings, float lineSpacing, float& Ascender, float& lineAdvance);
+	GlyphAtlas& getAtlas();
+
+	template <typename TIterator>
+	bool cacheString(TIterator itCodePoint, const TIterator& itEnd);
+
+	template <typename TIterator>
+	bool pinString(TIterator itCodePoint, const TIterator& itEnd);
+
+	template <typename TIterator>
+	bool drawString(TIterator itCodePoint, const TIterator& itEnd, float X, float Y);
+
+	template <typename TIterator>
+	bool drawCachedString(TIterator itCodePoint, const TIterator& itEnd, float X, float Y);
+	bool createStringImage(const std::vector<uint32_t>& Text, StringImage*& Image);
+
+	template <typename TIterator>
+	unsigned int getStringWidth(TIterator itCodePoint, const TIterator& itEnd);
+
+	template <typename TIterator>
+	unsigned int getStringHeight(TIterator itCodePoint, const TIterator& itEnd);
+
+	template <typename TIterator>
+	bool measureWidth(TIterator itCodePoint, const TIterator& itEnd, bool Cached, float& Width);
+
+	template <typename TIterator>
+	bool measureHeight(TIterator itCodePoint, const TIterator& itEnd, bool Cached, float& Height);
+
+	template <typename TIterator>
+	StringBounds getStringBounds(TIterator itCodePoint, const TIterator& itEnd);
+
+	template <typename TIterator>
+	bool measureBounds(TIterator itCodePoint, const TIterator& itEnd, bool Cached, float& Width, float& Height, float& Ascent, float& Descent);
+
+	friend class DynamicText;
+	friend class FontManager;
+	friend class Paragraph;
+	friend class TextRun;
+
+	FontManager* myManager;
+	sf::RenderWindow* myWindow;
+	/*
+		Shared with every other handle of the same font.
+	*/
+	FontFace* myFontFace;
+
+	Settings mySettings;
+	SettingsStack mySettingsStack;
+
+	/*
+		Quads for the string being drawn, refilled on every draw call.
+	*/
+	GlyphBatch myBatch;
+	/*
+		Images made by drawCachedString.
+	*/
+	StringImageCache myStringImages;
+	/*
+		Set by cacheChar when it gives the placeholder (or nothing) for
+		a glyph the workers are rendering (see LayoutGlyphs).
+	*/
+	bool myUsedPlaceholder;
+};
+
+}
+
+#endif
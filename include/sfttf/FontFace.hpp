@@ -0,0 +1,330 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#ifndef SFTTF_FONT_FACE_HPP
+#define SFTTF_FONT_FACE_HPP
+
+#include <sfttf/FontManager.hpp>
+#include <sfttf/Glyph.hpp>
+#include <sfttf/GlyphAtlas.hpp>
+#include <sfttf/GlyphPool.hpp>
+#include <sfttf/GlyphTable.hpp>
+#include <sfttf/Rasterizer.hpp>
+#include <sfttf/Reclaimer.hpp>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <SFML/Config.hpp>
+#include <SFML/System/NonCopyable.hpp>
+#include FT_STROKER_H
+
+namespace sfttf
+{
+
+class MappedFile;
+typedef unsigned int uint32_t;
+
+/*
+	A FontFace is one loaded font file (FreeType face) and its glyph cache.
+
+	The FontManager creates one FontFace per (file, face index) and shares it
+	between every Font handle loaded from it, so the file is parsed and every
+	glyph is rendered once no matter how many handles use it.
+	Everything here takes the size to work with, the handles keep the settings.
+*/
+class FontFace : public sf::NonCopyable
+{
+private:
+	/*
+		Most text is ASCII/Latin-1.
+		A FastTable maps those code points directly to the glyphs of one
+		(size, outline size, combined, phase) key, outline size 0 being the filled glyphs.
+		Slots start empty and are filled from myGlyphs the first time
+		they are looked up.
+	*/
+	static const unsigned int fastTableSize = 256;
+	/*
+		How many (size, outline size, combined, phase) keys keep a FastTable.
+		The least recently used table is recycled after that.
+	*/
+	static const unsigned int fastTableCount = 16;
+	struct FastTable
+	{
+		int Size;
+		int outlineSize;
+		bool Combined;
+		int Phase;
+		Glyph* Glyphs[fastTableSize];
+	};
+	typedef std::vector<FastTable*> FastTableList;
+
+	/*
+		Kerning only depends on the glyph pair and the size, so it is
+		kept per size instead of asking FreeType for every pair drawn.
+		Unfitted tables (for subpixel glyphs) are kept apart from the
+		ones rounded to whole pixels.
+
+		Pairs of printable ASCII characters are looked up in dense rows,
+		one per left character, filled the first time that character is
+		kerned at the size. Other pairs are added to otherPairs as they
+		are met.
+		Values are in 26.6 fixed point, like FreeType's.
+
+		A table lives in the slot its size and mode hash to in
+		myKerningSlots, replacing the table of another size there.
+		Tables and rows are published once filled and never changed
+		(see findKerning).
+	*/
+	static const unsigned int kerningFirst = 32;
+	static const unsigned int kerningRange = 95;
+	static const unsigned int kerningTableCount = 64;
+	struct Kerning
+	{
+		FT_Pos X;
+		FT_Pos Y;
+	};
+	typedef std::map<std::pair<unsigned int, unsigned int>, Kerning> KerningMap;
+	struct KerningTable
+	{
+		int Size;
+		bool Unfitted;
+		Kerning* asciiRows[kerningRange];
+		KerningMap otherPairs;
+	};
+
+	/*
+		Glyphs queued for the workers (true) or that they failed
+		to render (false, rendered by the face from then on).
+		Cleared with the glyphs.
+	*/
+	typedef std::map<GlyphKey, bool> PendingMap;
+
+	/*
+		Distance field glyphs (see Font::setDistanceField) have a Size of 0.
+		They are rendered once at distanceFieldSize pixels, FreeType
+		rendering them distanceFieldOversampling times larger for accuracy.
+		The field reaches distanceFieldSpread pixels (at distanceFieldSize)
+		each side of the edge, and the glyph is padded by as much.
+	*/
+	static const int distanceFieldSize = 48;
+	static const int distanceFieldSpread = 6;
+	static const int distanceFieldOversampling = 4;
+
+	/*
+		Subpixel glyphs (see Font::setSubpixel) are rendered at this many
+		horizontal offsets, Phase 1 being the unmoved one.
+	*/
+	static const int subpixelPhases = 4;
+
+	/*
+	Quick helper class to insure FT_Done_Glyph is called on an FT_Glyph
+	*/
+	struct FreeGlyph
+	{
+		FreeGlyph(FT_Glyph* Glyph) : myGlyph(Glyph)
+		{}
+
+		~FreeGlyph()
+		{
+			if (0 != myGlyph)
+				FT_Done_Glyph(*myGlyph);
+		}
+
+	private:
+		FT_Glyph* myGlyph;
+	};
+
+	/*
+		With ownFreeType the face frees FreeType with itself, for faces
+		opened on another thread with a library of their own (see FontLoader).
+	*/
+	FontFace(FontManager* Manager, FT_Library FreeType, bool ownFreeType = false);
+	~FontFace();
+
+	void clearCache();
+	void setCacheBudget(std::size_t Bytes);
+	std::size_t getCacheBudget() const;
+	std::size_t getCacheSize() const;
+	void unpinAll();
+
+	bool saveCache(const std::string& Filename);
+	bool loadCache(const std::string& Filename);
+
+	bool Initialize(const MappedFile& File, long faceIndex);
+	void Deinitialize();
+
+	Glyph* cacheGlyph(const GlyphKey& Key, bool Async, bool& Pending);
+	bool isPending(const GlyphKey& Key) const;
+	void collectGlyphs();
+	Glyph* addRendered(const RenderedGlyph& Rendered);
+
+	static bool renderGlyph(Rasterizer& Raster, RenderedGlyph& Rendered);
+	static bool renderFill(Rasterizer& Raster, RenderedGlyph& Rendered);
+	static bool renderOutline(Rasterizer& Raster, RenderedGlyph& Rendered);
+	static bool renderCombined(Rasterizer& Raster, RenderedGlyph& Rendered);
+	static bool renderDistanceField(Rasterizer& Raster, RenderedGlyph& Rendered);
+
+	Glyph* getMetrics(const GlyphKey& Key);
+	static bool measureGlyph(Rasterizer& Raster, const GlyphKey& Key, Glyph& Metrics);
+
+	Glyph* getGlyph(uint32_t codePoint, int Size, int Phase);
+	Glyph* getGlyphOutline(uint32_t codePoint, int Size, int outlineSize, int Phase);
+	Glyph* getGlyphCombined(uint32_t codePoint, int Size, int outlineSize, int Phase);
+	Glyph* findGlyph(const GlyphKey& Key);
+	bool findKerning(const Glyph* leftGlyph, const Glyph* rightGlyph, int Size, bool Unfitted, int* offsetX, int* offsetY) const;
+	FastTable* getFastTable(int Size, int outlineSize, bool Combined, int Phase);
+	static FT_Pos getPhaseOffset(int Phase);
+	static int getAdvance(const Rasterizer& Raster, FT_Glyph Glyph, int Phase);
+	void clearFastTables();
+	static unsigned int getKerningSlot(int Size, bool Unfitted);
+	KerningTable* getKerningTable(int Size, bool Unfitted);
+	void clearKerningTables();
+
+	void beginUse();
+	void addGlyph(const GlyphKey& Key, Glyph* g);
+	void touchGlyph(Glyph* g);
+	void pinGlyph(Glyph* g);
+	void holdGlyph(Glyph* g);
+	void releaseGlyph(Glyph* g);
+	void linkGlyph(Glyph* g);
+	void unlinkGlyph(Glyph* g);
+	void evictGlyph(Glyph* g);
+	Glyph* getLeastRecentlyUsed() const;
+	void trimCache(std::size_t Budget);
+	static std::size_t getGlyphMemory(const Glyph* g);
+	static void freeGlyph(void* Owner, void* Object);
+	static void freeGlyphPool(void* Owner, void* Object);
+	static void freeKerningTable(void* Owner, void* Object);
+
+	sf::Uint32 getFontHash();
+
+	Glyph* createGlyph(const FT_Bitmap& Bitmap, const unsigned char* outlineShare, int Left, int Top, int xAdvanceFixed, unsigned int Index, int Size, int outlineSize);
+
+	void getKerning(Glyph* leftGlyph, Glyph* rightGlyph, int Size, bool Unfitted, int* offsetX, int* offsetY);
+	bool getLineMetrics(int Size, int& Ascender, int& lineHeight);
+
+	friend class Font;
+	friend class FontLoader;
+	friend class FontManager;
+	friend class GlyphWorkers;
+
+	FontManager* myManager;
+	FT_Library myFreeType;
+	bool myOwnFreeType;
+	/*
+		Renders the glyphs that are not left to the workers,
+		and is used for kerning.
+	*/
+	Rasterizer myRasterizer;
+
+	bool myHaveKerning;
+
+	/*
+		The mapped font file, shared with other faces of the same file.
+		myFontHash identifies it in cache files, see getFontHash.
+	*/
+	const MappedFile* myFontFile;
+	sf::Uint32 myFontHash;
+
+	/*
+		Font handles using this face, and where the face and its file are
+		in the FontManager's maps (for unloading).
+	*/
+	unsigned int myReferences;
+	FontManager::FaceMap::iterator myEntry;
+	FontManager::FileMap::iterator myFile;
+
+	/*
+		Frees what lookups without the lock may still use: glyphs, table
+		blocks, kerning tables and, after clearCache, the glyph pool.
+		Declared before everything that retires to it.
+	*/
+	Reclaimer myReclaimer;
+
+	/*
+		Filled, outlined and combined glyphs of every size.
+		The records themselves live in myGlyphPool, which clearCache
+		replaces with a new one.
+	*/
+	GlyphTable myGlyphs;
+	/*
+		Glyphs that were measured but not rendered (see getMetrics):
+		no texture, only their size, position and advance.
+		They come from myGlyphPool and are counted and evicted like the
+		others, and dropped once the glyph is rendered.
+	*/
+	GlyphTable myMeasured;
+	GlyphPool* myGlyphPool;
+	/*
+		Most recently used first.
+	*/
+	FastTableList myFastTables;
+	KerningTable* myKerningSlots[kerningTableCount];
+	/*
+		Glyph indices of the printable ASCII characters, for the kerning rows.
+	*/
+	FT_UInt myAsciiIndices[kerningRange];
+
+	/*
+		Glyphs neither pinned nor held, most recently used at the head.
+	*/
+	Glyph* myLruHead;
+	Glyph* myLruTail;
+	std::size_t myCacheSize;
+	std::size_t myCacheBudget;
+	/*
+		Taken from the FontManager's counter at the start of every call
+		that uses glyphs (see beginUse).
+		Glyphs with this lastUsed value are in use while it is still the
+		manager's stamp, and must not be evicted.
+	*/
+	unsigned int myUseStamp;
+	/*
+		Incremented when the cache is cleared, so the text drawables
+		know the glyphs they hold are gone (see Font::LayoutGlyphs).
+		Held glyphs are never evicted otherwise.
+	*/
+	unsigned int myClearCount;
+	/*
+		Incremented when glyphs arrive from the workers, for layouts
+		made with placeholders meanwhile.
+	*/
+	unsigned int myArrivalCount;
+
+	PendingMap myPending;
+
+	/*
+		Textures for every glyph (filled, outlined and combined) of this face.
+	*/
+	GlyphAtlas myAtlas;
+};
+
+}
+
+#endif
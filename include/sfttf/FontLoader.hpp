@@ -0,0 +1,104 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#ifndef SFTTF_FONT_LOADER_HPP
+#define SFTTF_FONT_LOADER_HPP
+
+#include <sfttf/FontManager.hpp>
+#include <SFML/System/Thread.hpp>
+
+namespace sfttf
+{
+
+class FontFace;
+
+/*
+	A font being loaded on another thread (see FontManager::loadFontAsync).
+
+	The thread reads the whole file, so it is in memory by the time the
+	font is used, and opens the face with a FreeType library of its own,
+	FreeType libraries not being thread-safe. It does not touch the
+	FontManager: the face is only added to it by FontManager::finishLoad,
+	on the thread that started the load.
+*/
+class FontLoader : private sf::Thread
+{
+public:
+	/*
+		True once the thread is done, whether the font could be loaded
+		or not. Never blocks, for polling while the application keeps
+		drawing.
+	*/
+	bool isDone() const;
+	/*
+		Blocks until the thread is done.
+	*/
+	void Wait();
+
+private:
+	friend class FontManager;
+
+	/*
+		Only the FontManager creates loaders. The thread is not started
+		if File is the manager's end of files, the face being loaded
+		already.
+	*/
+	FontLoader(FontManager* Manager, const FontManager::FaceKey& Key, FontManager::FileMap::iterator File);
+	/*
+		Waits for the thread, and deletes the face if it was not taken.
+	*/
+	~FontLoader();
+
+	virtual void Run();
+
+	FontManager* myManager;
+	FontManager::FaceKey myKey;
+	/*
+		The manager's mapping of the file, with a reference added for
+		the loader. The thread only reads myMapping, taken beforehand
+		as the manager's maps may change meanwhile.
+	*/
+	FontManager::FileMap::iterator myFile;
+	const MappedFile* myMapping;
+	bool myStarted;
+
+	/*
+		Set by the thread, 0 if the face could not be opened.
+		Only read once the thread has been waited for.
+	*/
+	FontFace* myFace;
+	/*
+		Set to 1 by the thread when it is done, read with atomicLoad.
+	*/
+	long myDone;
+
+	FontManager::LoaderList::iterator myHandle;
+};
+
+}
+
+#endif
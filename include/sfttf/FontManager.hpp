@@ -1,97 +1,282 @@
-/**********************************************************************
-Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
-All rights reserved.
-
-Redistribution and use in source and binary forms, with or without
-modification, are permitted provided that the following conditions
-are met:
-
-* Redistributions of source code must retain the above copyright
-notice, this list of conditions and the following disclaimer.
-
-* Redistributions in binary form must reproduce the above copyright
-notice, this list of conditions and the following disclaimer in the
-documentation and/or other materials provided with the distribution.
-
-THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
-"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
-LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
-A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
-OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
-SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
-LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
-DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
-THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
-(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
-OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-**********************************************************************/
-#ifndef SFTTF_FONT_MANAGER_HPP
-#define SFTTF_FONT_MANAGER_HPP
-
-#include <list>
-#include <string>
-#include <SFML/Graphics/RenderWindow.hpp>
-#include <SFML/System/NonCopyable.hpp>
-
-#include <ft2build.h>
-#include FT_FREETYPE_H
-
-namespace sfttf
-{
-
-class Font;
-class FontManager : public sf::NonCopyable
-{
-public:
-	FontManager();
-	~FontManager();
-
-	/*
-		This must be explicitly called prior to use!
-
-		Calling it multiple times will cause it to Deinitialize and Reinitialize,
-		unloading all fonts in the process.
-	*/
-	bool Initialize(sf::RenderWindow* Window);
-	/*
-		This does not need to be called explicitly, it will be called in the destructor.
-		However, you are free to call it.
-		It will unload all fonts, thus your font pointers will be invalid.
-		You must call Initialize again before using it.
-	*/
-	bool Deinitialize();
-
-	/*
-		Load a font.
-
-		Returns the font handle or 0 if it failed.
-	*/
-	sfttf::Font* loadFont(const std::string& Filename);
-
-	/*
-		Unload a font.
-
-		If the font does not belong to this font manager, this call
-		does nothing.
-
-		Otherwise, after this call the pointer is invalid.
-	*/
-	void unloadFont(sfttf::Font* Font);
-
-	/*
-		Unload all fonts.
-	*/
-	void unloadFonts();
-
-private:
-	sf::RenderWindow* myWindow;
-	FT_Library myFreeType;
-
-	typedef std::list<sfttf::Font*> FontList;
-	FontList myFonts;
-
-};
-
-}
-
-#endif
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#ifndef SFTTF_FONT_MANAGER_HPP
+#define SFTTF_FONT_MANAGER_HPP
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sfttf/GlyphWorkers.hpp>
+#include <sfttf/MappedFile.hpp>
+#include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/System/Mutex.hpp>
+#include <SFML/System/NonCopyable.hpp>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+namespace sfttf
+{
+
+class Font;
+class FontFace;
+class FontLoader;
+class FontManager : public sf::NonCopyable
+{
+public:
+	FontManager();
+	~FontManager();
+
+	/*
+		This must be explicitly called prior to use!
+
+		Calling it multiple times will cause it to Deinitialize and Reinitialize,
+		unloading all fonts in the process.
+	*/
+	bool Initialize(sf::RenderWindow* Window);
+	/*
+		This does not need to be called explicitly, it will be called in the destructor.
+		However, you are free to call it.
+		It will unload all fonts, thus your font pointers will be invalid.
+		You must call Initialize again before using it.
+	*/
+	bool Deinitialize();
+
+	/*
+		Load a font.
+		faceIndex selects the face in font files that contain several (.ttc).
+
+		Loading a file that is already loaded does not parse it again,
+		the new handle shares the font face and glyph cache of the others
+		(see Font).
+
+		Returns the font handle or 0 if it failed.
+	*/
+	sfttf::Font* loadFont(const std::string& Filename, long faceIndex = 0);
+
+	/*
+		Start loading a font on another thread, so the application can
+		keep drawing meanwhile (see FontLoader). Poll the loader with
+		isDone, or Wait for it, then give it to finishLoad for the font.
+
+		A font that is already loaded is not loaded again, its loader
+		is done at once.
+
+		Returns the loader or 0 if the file cannot be opened.
+	*/
+	sfttf::FontLoader* loadFontAsync(const std::string& Filename, long faceIndex = 0);
+	/*
+		Wait for Loader if it is not done, and return its font handle
+		as loadFont would, 0 if it failed.
+
+		If Loader does not belong to this font manager, this call
+		does nothing and returns 0.
+		Otherwise, after this call the loader pointer is invalid.
+	*/
+	sfttf::Font* finishLoad(sfttf::FontLoader* Loader);
+
+	/*
+		Unload a font.
+
+		If the font does not belong to this font manager, or was
+		already unloaded, this call does nothing.
+
+		Otherwise, after this call the pointer is invalid.
+		The font face is unloaded with its last handle.
+	*/
+	void unloadFont(sfttf::Font* Font);
+
+	/*
+		Unload all fonts.
+		Loaders not finished yet are waited for and deleted.
+	*/
+	void unloadFonts();
+
+	/*
+		Limit the memory used by the cached glyphs of all fonts together, in bytes.
+		0 (the default) means no limit.
+
+		This works on top of each font's own budget (see Font::setCacheBudget),
+		evicting the least recently used glyphs across all fonts.
+	*/
+	void setCacheBudget(std::size_t Bytes);
+	std::size_t getCacheBudget() const;
+	std::size_t getCacheSize() const;
+
+	/*
+		Start Count threads that render glyphs in the background for
+		fonts that ask for it (see Font::setAsync).
+		0 (the default) stops them, glyphs are then always rendered
+		by the thread that draws.
+	*/
+	void setWorkerCount(unsigned int Count);
+	unsigned int getWorkerCount() const;
+
+	/*
+		Glyphs for prewarmCaches to render: Text at every size of Sizes,
+		and outlined at every size of outlineSizes. The font's other
+		settings (fill, combine, distance field, subpixel) are used.
+
+		Success is set if every glyph could be rendered, Seconds to the
+		time from the start of prewarmCaches until they all were.
+	*/
+	struct PrewarmJob
+	{
+		PrewarmJob() : Font(0),
+					   Success(false),
+					   Seconds(0.0f)
+		{}
+		sfttf::Font* Font;
+		std::vector<int> Sizes;
+		std::vector<int> outlineSizes;
+		std::wstring Text;
+
+		bool Success;
+		float Seconds;
+	};
+	typedef std::vector<PrewarmJob> PrewarmJobList;
+
+	/*
+		Cache the glyphs of every job, rendered in parallel by Threads
+		threads (0 for one per processor), and wait until they are.
+		Workers are started for the call if there are fewer running
+		(see setWorkerCount).
+		In thread-safe mode, other threads keep drawing while it waits:
+		the lock is only taken to queue and collect the glyphs.
+
+		Returns true if every job succeeded.
+	*/
+	bool prewarmCaches(PrewarmJobList& Jobs, unsigned int Threads = 0);
+
+	/*
+		Allow fonts to be used from several threads at once, e.g. to lay
+		out and measure text on other threads while one thread draws.
+		Off by default. Turn it on from the drawing thread, before other
+		threads use the fonts.
+
+		Calls on fonts, text runs and this manager then take a lock
+		(one for the whole manager, glyph caches can evict each other's
+		glyphs), so they do not run at the same time but are safe.
+		What belongs to a Font handle is not shared: its settings, the
+		Push/Pop stack and the quads of the string being drawn. Give each
+		thread its own handle, loading the font again gives a new handle
+		sharing the same cache.
+		Drawing, and the calls that release textures (clearCache,
+		loadCache, unloading the last handle of a font), still have to
+		be made by the thread that owns the window.
+	*/
+	void setThreadSafe(bool ThreadSafe);
+	bool isThreadSafe() const;
+
+private:
+	friend class Font;
+	friend class FontFace;
+	friend class FontLoader;
+
+	/*
+		Taken by every public call that uses fonts, once, when the
+		manager is thread-safe. sf::Mutex is not recursive everywhere,
+		so calls made while it is held must not take it again.
+	*/
+	class UseLock : public sf::NonCopyable
+	{
+	public:
+		explicit UseLock(const FontManager& Manager);
+		~UseLock();
+
+	private:
+		sf::Mutex* myMutex;
+	};
+
+	/*
+		Every font file is mapped once, its faces read from the mapping.
+		References counts the faces using it.
+	*/
+	struct SharedFile
+	{
+		SharedFile() : References(0)
+		{}
+		MappedFile File;
+		unsigned int References;
+	};
+	typedef std::map<std::string, SharedFile*> FileMap;
+
+	FileMap::iterator openFile(const std::string& Filename);
+	void closeFile(FileMap::iterator itFile);
+
+	/*
+		loadFont without the lock.
+	*/
+	sfttf::Font* openFont(const std::string& Filename, long faceIndex);
+	sfttf::Font* addFont(sfttf::FontFace* Face);
+
+	std::size_t getTotalCacheSize() const;
+	void trimCaches();
+
+	bool queuePrewarm(const PrewarmJob& Job, std::vector<GlyphKey>& Keys);
+
+	sf::RenderWindow* myWindow;
+	FT_Library myFreeType;
+
+	std::size_t myCacheBudget;
+	/*
+		Incremented by fonts at the start of every call that uses glyphs,
+		so glyph use can be compared between fonts.
+	*/
+	unsigned int myUseStamp;
+
+	typedef std::list<sfttf::Font*> FontList;
+	FontList myFonts;
+
+	/*
+		Loaders not finished yet.
+	*/
+	typedef std::list<sfttf::FontLoader*> LoaderList;
+	LoaderList myLoaders;
+
+	/*
+		Loaded font faces by file name and face index.
+	*/
+	typedef std::pair<std::string, long> FaceKey;
+	typedef std::map<FaceKey, sfttf::FontFace*> FaceMap;
+	FaceMap myFaces;
+
+	FileMap myFiles;
+
+	GlyphWorkers myWorkers;
+
+	bool myThreadSafe;
+	mutable sf::Mutex myMutex;
+};
+
+}
+
+#endif
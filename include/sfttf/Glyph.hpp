@@ -1,104 +1,125 @@
-/**********************************************************************
-Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
-All rights reserved.
-
-Redistribution and use in source and binary forms, with or without
-modification, are permitted provided that the following conditions
-are met:
-
-* Redistributions of source code must retain the above copyright
-notice, this list of conditions and the following disclaimer.
-
-* Redistributions in binary form must reproduce the above copyright
-notice, this list of conditions and the following disclaimer in the
-documentation and/or other materials provided with the distribution.
-
-THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
-"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
-LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
-A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
-OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
-SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
-LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
-DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
-THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
-(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
-OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-**********************************************************************/
-#ifndef SFTTF_GLYPH_HPP
-#define SFTTF_GLYPH_HPP
-
-#include <SFML/Graphics/RenderWindow.hpp>
-#include <SFML/Graphics/Image.hpp>
-#include <SFML/Graphics/Sprite.hpp>
-#include <ft2build.h>
-#include FT_FREETYPE_H
-#include FT_STROKER_H
-
-namespace sfttf
-{
-
-struct Glyph
-{
-	/*
-		Actual glyph dimensions, not texture dimensions
-	*/
-	int glyphWidth;
-	int glyphHeight;
-
-	unsigned int glyphIndex;
-	int xAdvance;
-	int bitmapLeft;
-	int bitmapTop;
-
-	sf::Image Texture;
-	/*
-		We have a few choices here:
-		-Use 1 sprite for each Glyph (this is what we do now).
-		-Share a static sprite, setting it up each time we draw
-		-Use custom drawing code (likely the fastest)
-	*/
-	sf::Sprite Sprite;
-
-	int Size;
-	/*
-		Only valid for outline glyphs.
-	*/
-	int outlineSize;
-
-	bool renderTexture(FT_Bitmap Bitmap);
-	void Setup(const FT_Bitmap& Bitmap,
-				sf::RenderWindow* theWindow,
-				int Left,
-				int Top,
-				int theXAdvance,
-				unsigned int Index,
-				int theSize,
-				int theOutlineSize);
-
-	bool Draw(float X, float Y, const sf::Color& Color);
-
-private:
-	/*
-		This is used by renderGlyph/renderGlyphOutline.
-		It is only resized when less than the required size.
-		It is shared between all Glyph's, and thus not thread-safe.
-
-		Basically it comes down to two methods to create an sf::Image:
-		-SetPixel
-		-LoadFromPixels
-
-		We're going for LoadFromPixels so we can avoid calling SetPixel
-		once per pixel.
-		SetPixel doesn't look very expensive (and may be inline-able),
-		but this may help anyways.
-	*/
-	typedef std::vector<sf::Uint8> PixelBuffer;
-	static PixelBuffer Pixels;
-
-	sf::RenderWindow* Window;
-};
-
-}
-
-#endif
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#ifndef SFTTF_GLYPH_HPP
+#define SFTTF_GLYPH_HPP
+
+#include <SFML/Graphics/Rect.hpp>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+namespace sfttf
+{
+
+struct Glyph
+{
+	/*
+		Actual glyph dimensions, not texture dimensions
+	*/
+	int glyphWidth;
+	int glyphHeight;
+
+	unsigned int glyphIndex;
+	int xAdvance;
+	/*
+		xAdvance in 26.6 fixed point, unrounded for subpixel and
+		distance field glyphs.
+	*/
+	int xAdvanceFixed;
+	int bitmapLeft;
+	int bitmapTop;
+
+	/*
+		Where the glyph lives in its font's GlyphAtlas.
+		Glyphs without a bitmap (e.g. space) have an empty textureRect.
+	*/
+	unsigned int Page;
+	sf::IntRect textureRect;
+
+	unsigned int codePoint;
+	/*
+		0 for distance field glyphs, which are drawn at any size.
+		Their metrics are at the size they were rendered at
+		(see FontFace::distanceFieldSize) and the texture is larger than
+		glyphWidth/glyphHeight by the field's padding.
+	*/
+	int Size;
+	/*
+		Only valid for outline glyphs.
+	*/
+	int outlineSize;
+	/*
+		Combined glyphs hold the fill and the outline in one texture:
+		alpha is the coverage of both, the color channels the share of
+		the outline, so both colors are applied when drawn (see GlyphBatch).
+	*/
+	bool Combined;
+	/*
+		Subpixel glyphs (see Font::setSubpixel) are rendered moved right by
+		(Phase - 1) / FontFace::subpixelPhases of a pixel, and drawn at whole
+		pixels. Phase is 0 for other glyphs.
+	*/
+	int Phase;
+
+	/*
+		Least recently used list, kept by the font.
+		Pinned and held glyphs are not in the list, so they are never evicted.
+		Holds counts the text drawables whose layout uses the glyph
+		(see Font::LayoutGlyphs).
+		Measured glyphs (see FontFace::getMetrics) are in the list too.
+	*/
+	Glyph* lruPrevious;
+	Glyph* lruNext;
+	unsigned int lastUsed;
+	bool Pinned;
+	bool Measured;
+	unsigned int Holds;
+
+	void Setup(const FT_Bitmap& Bitmap,
+				int Left,
+				int Top,
+				int theXAdvanceFixed,
+				unsigned int Index,
+				int theSize,
+				int theOutlineSize);
+	/*
+		For glyphs that are only measured (see FontFace::getMetrics),
+		Width by Height being the size of the bitmap they would have.
+	*/
+	void Setup(unsigned int Width,
+				unsigned int Height,
+				int Left,
+				int Top,
+				int theXAdvanceFixed,
+				unsigned int Index,
+				int theSize,
+				int theOutlineSize);
+};
+
+}
+
+#endif
@@ -0,0 +1,189 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#ifndef SFTTF_GLYPH_ATLAS_HPP
+#define SFTTF_GLYPH_ATLAS_HPP
+
+#include <cstddef>
+#include <vector>
+#include <SFML/Config.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/NonCopyable.hpp>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+namespace sfttf
+{
+
+/*
+	A GlyphAtlas packs glyph bitmaps into a few large textures (pages)
+	so a whole string can be drawn from one texture.
+
+	Pages are filled with simple shelf packing:
+	-Glyphs are placed left to right on a shelf (a row as tall as its tallest glyph)
+	-When no shelf has room, a new shelf is opened below the last one
+	-When no page has room for a new shelf, a new page is created
+
+	Freed areas are reused for glyphs that fit in them: a glyph takes
+	the corner of the smallest one it fits in, the rest stays free, and
+	freed areas next to each other are merged again. A page whose
+	glyphs are all freed is released, its pixels and texture are
+	only allocated again when a glyph is placed on it.
+
+	Pages hold one byte of coverage per pixel (an alpha texture, colored
+	when drawn). Combined glyphs go on their own pages with the outline
+	share next to the coverage (a luminance/alpha texture).
+*/
+class GlyphAtlas : public sf::NonCopyable
+{
+public:
+	GlyphAtlas();
+	~GlyphAtlas();
+
+	/*
+		Reserve a Width x Height area, on a combined page if Combined is true.
+		Page and Rect receive its location.
+	*/
+	bool Allocate(unsigned int Width, unsigned int Height, bool Combined, unsigned int& Page, sf::IntRect& Rect);
+
+	/*
+		Copy coverage into an area returned by Allocate.
+		The texture is updated the next time the page is used.
+
+		8-bit gray, mono and LCD bitmaps are accepted, LCD samples
+		are averaged into one coverage value per pixel.
+
+		Combined glyphs (see Glyph::Combined) also give outlineShare,
+		one byte per pixel, Bitmap.width bytes per row. It is 0 for others,
+		and must be given for areas on combined pages.
+	*/
+	void Upload(unsigned int Page, const sf::IntRect& Rect, const FT_Bitmap& Bitmap, const unsigned char* outlineShare);
+
+	/*
+		Copy the coverage of an area back out, one byte per pixel,
+		Rect.GetWidth() bytes per row.
+		outlineShare, if not 0, receives the outline share the same way
+		(255 outside combined pages).
+	*/
+	void Download(unsigned int Page, const sf::IntRect& Rect, unsigned char* Coverage, unsigned char* outlineShare) const;
+
+	/*
+		Give back an area returned by Allocate.
+	*/
+	void Free(unsigned int Page, const sf::IntRect& Rect);
+
+	/*
+		Bind a page's texture, creating or updating it first if needed.
+	*/
+	void Bind(unsigned int Page);
+
+	unsigned int getPageWidth(unsigned int Page) const;
+	unsigned int getPageHeight(unsigned int Page) const;
+
+	/*
+		Release all pages.
+	*/
+	void Clear();
+
+	unsigned int getPageCount() const;
+
+	/*
+		Bytes used by all pages, in RAM and again in texture memory.
+	*/
+	std::size_t getMemory() const;
+
+	/*
+		Size of a bitmap in pixels (LCD bitmaps have three samples per pixel),
+		the area to Allocate for it.
+	*/
+	static unsigned int getBitmapWidth(const FT_Bitmap& Bitmap);
+	static unsigned int getBitmapHeight(const FT_Bitmap& Bitmap);
+
+	/*
+		Writes Width luminance/alpha pixels of a combined page:
+		outlineShare in luminance, Coverage in alpha.
+		Upload uses the SSE2 one when the processor has it, Vectorized
+		false always gives the scalar one (to compare them, see the
+		Test program's benchmarks).
+	*/
+	typedef void (*RowConverter)(const unsigned char* Coverage, const unsigned char* outlineShare, sf::Uint8* Destination, unsigned int Width);
+	static RowConverter getRowConverter(bool Vectorized = true);
+
+private:
+	struct Shelf
+	{
+		unsigned int Y;
+		unsigned int Height;
+		/*
+			Width used so far.
+		*/
+		unsigned int Width;
+	};
+	typedef std::vector<Shelf> ShelfList;
+
+	struct Page
+	{
+		unsigned int Width;
+		unsigned int Height;
+		/*
+			Top of the free area below the last shelf.
+		*/
+		unsigned int shelfBottom;
+		ShelfList Shelves;
+		/*
+			Freed areas (including padding) that can be handed out again,
+			and the space left below glyphs shorter than their shelf.
+		*/
+		std::vector<sf::IntRect> freeRects;
+		unsigned int glyphCount;
+		bool Combined;
+
+		/*
+			Pages are built here, then sent to the texture when Dirty (see Bind).
+			Texture is an OpenGL texture name, 0 until the page is first bound.
+			Both are released (Pixels empty) while the page has no glyphs.
+		*/
+		std::vector<sf::Uint8> Pixels;
+		bool Dirty;
+		unsigned int Texture;
+	};
+	typedef std::vector<Page*> PageList;
+
+	Page* createPage(unsigned int Width, unsigned int Height, bool Combined);
+	static void clearPixels(Page* thePage);
+	static void releasePage(Page* thePage);
+	static unsigned int getBytesPerPixel(const Page* thePage);
+	static void addFreeRect(Page* thePage, sf::IntRect Rect);
+	bool allocateFreeRect(Page* thePage, unsigned int Width, unsigned int Height, sf::IntRect& Rect);
+	bool allocateOnPage(Page* thePage, unsigned int Width, unsigned int Height, sf::IntRect& Rect);
+
+	PageList myPages;
+};
+
+}
+
+#endif
@@ -0,0 +1,152 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#ifndef SFTTF_GLYPH_BATCH_HPP
+#define SFTTF_GLYPH_BATCH_HPP
+
+#include <cstddef>
+#include <vector>
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Rect.hpp>
+
+namespace sfttf
+{
+
+struct Glyph;
+class GlyphAtlas;
+
+/*
+	A GlyphBatch collects glyph quads and draws them with one call per atlas page.
+
+	Quads are kept in the order they are added, so within a page the
+	result is the same as drawing each glyph on its own.
+	Combined glyphs are drawn after the others, grouped by outline color,
+	then distance field glyphs, grouped by outline color and width.
+*/
+class GlyphBatch : public sf::Drawable
+{
+public:
+	explicit GlyphBatch(GlyphAtlas& Atlas);
+
+	/*
+		Add a quad for g with its top left corner at X, Y.
+	*/
+	void Add(const Glyph& g, float X, float Y, const sf::Color& Color);
+
+	/*
+		Add a quad for a combined glyph (see Glyph::Combined), its fill
+		drawn with Color and its outline with outlineColor.
+		Both colors should have the same alpha.
+	*/
+	void Add(const Glyph& g, float X, float Y, const sf::Color& Color, const sf::Color& outlineColor);
+
+	/*
+		Add a quad for a distance field glyph (see Glyph::Size), Scale times
+		the size of its texture. Transparent colors disable fill or outline.
+		outlineWidth is in field units, see DistanceFieldProgram::Bind.
+	*/
+	void Add(const Glyph& g, float X, float Y, float Scale, const sf::Color& Color, const sf::Color& outlineColor, float outlineWidth);
+
+	/*
+		Remove all quads.
+		Memory is kept so the batch can be refilled without allocating.
+	*/
+	void Clear();
+
+	bool isEmpty() const;
+
+	/*
+		Smallest rectangle containing every quad.
+	*/
+	const sf::FloatRect& getBounds() const;
+
+	/*
+		Draw the quads into a Width x Height RGBA image instead of the
+		window, in the same order, moved by OffsetX, OffsetY.
+		Quads must be at whole pixel positions.
+		Distance field quads are not drawn.
+	*/
+	void Composite(sf::Uint8* Pixels, unsigned int Width, unsigned int Height, int OffsetX, int OffsetY) const;
+
+	/*
+		Whether combined glyphs can be drawn (OpenGL 1.3 or
+		ARB_texture_env_combine). Needs a current context.
+	*/
+	static bool isCombineSupported();
+
+protected:
+	virtual void Render(sf::RenderTarget& Target) const;
+
+private:
+	struct Vertex
+	{
+		float X;
+		float Y;
+		float U;
+		float V;
+		sf::Uint8 Color[4];
+	};
+	typedef std::vector<Vertex> VertexList;
+	/*
+		Indexed by atlas page.
+	*/
+	typedef std::vector<VertexList> PageVertices;
+	/*
+		The outline is a texture environment or program setting,
+		so combined and distance field quads need one group per outline.
+	*/
+	struct QuadGroup
+	{
+		sf::Color outlineColor;
+		float outlineWidth;
+		PageVertices Pages;
+	};
+	typedef std::vector<QuadGroup> QuadGroupList;
+
+	static PageVertices& getGroup(QuadGroupList& Groups, std::size_t& Count, const sf::Color& outlineColor, float outlineWidth);
+	static void clearGroups(QuadGroupList& Groups, std::size_t& Count);
+	void addQuad(PageVertices& Pages, const Glyph& g, float X, float Y, float Scale, const sf::Color& Color);
+	void compositePages(const PageVertices& Pages, const sf::Color* outlineColor, sf::Uint8* Pixels, unsigned int Width, unsigned int Height, int OffsetX, int OffsetY) const;
+	void drawPages(const PageVertices& Pages) const;
+
+	GlyphAtlas* myAtlas;
+	PageVertices myVertices;
+	/*
+		Groups past the count are unused, kept for their memory.
+	*/
+	QuadGroupList myCombined;
+	std::size_t myCombinedCount;
+	QuadGroupList myDistanceFields;
+	std::size_t myDistanceFieldCount;
+	bool myEmpty;
+	sf::FloatRect myBounds;
+};
+
+}
+
+#endif
@@ -0,0 +1,83 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#ifndef SFTTF_GLYPH_POOL_HPP
+#define SFTTF_GLYPH_POOL_HPP
+
+#include <vector>
+#include <SFML/System/NonCopyable.hpp>
+
+namespace sfttf
+{
+
+struct Glyph;
+
+/*
+	Allocates Glyph records from a few large slabs instead of one heap
+	allocation per glyph.
+
+	-Slabs double in size (up to a limit), so warming up a large font
+	 only takes a handful of allocations
+	-Freed glyphs go on a free list and are handed out again first
+	-Clear releases every slab at once
+*/
+class GlyphPool : public sf::NonCopyable
+{
+public:
+	GlyphPool();
+	~GlyphPool();
+
+	Glyph* Allocate();
+	void Free(Glyph* g);
+
+	/*
+		Releases every glyph, all pointers become invalid.
+	*/
+	void Clear();
+
+private:
+	struct Slab
+	{
+		Glyph* Glyphs;
+		unsigned int Size;
+	};
+	typedef std::vector<Slab> SlabList;
+
+	SlabList mySlabs;
+	/*
+		Glyphs handed out from the last slab so far.
+	*/
+	unsigned int myUsed;
+	/*
+		Freed glyphs, linked through Glyph::lruNext.
+	*/
+	Glyph* myFreeList;
+};
+
+}
+
+#endif
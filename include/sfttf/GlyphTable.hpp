@@ -0,0 +1,178 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#ifndef SFTTF_GLYPH_TABLE_HPP
+#define SFTTF_GLYPH_TABLE_HPP
+
+#include <vector>
+#include <SFML/System/NonCopyable.hpp>
+
+namespace sfttf
+{
+
+struct Glyph;
+class Reclaimer;
+
+/*
+	Everything that identifies a cached glyph.
+	Filled glyphs have an outlineSize of 0.
+	Combined glyphs (fill and outline together) have Combined set.
+	Glyphs placed on whole pixels have a Phase of 0 (see Glyph::Phase).
+*/
+struct GlyphKey
+{
+	GlyphKey() : codePoint(0),
+				 Size(0),
+				 outlineSize(0),
+				 Combined(false),
+				 Phase(0)
+	{}
+	GlyphKey(unsigned int theCodePoint, int theSize, int theOutlineSize, bool theCombined, int thePhase) : codePoint(theCodePoint),
+																										   Size(theSize),
+																										   outlineSize(theOutlineSize),
+																										   Combined(theCombined),
+																										   Phase(thePhase)
+	{}
+
+	bool operator==(const GlyphKey& Other) const
+	{
+		return codePoint == Other.codePoint &&
+			Size == Other.Size &&
+			outlineSize == Other.outlineSize &&
+			Combined == Other.Combined &&
+			Phase == Other.Phase;
+	}
+
+	bool operator<(const GlyphKey& Other) const
+	{
+		if (codePoint != Other.codePoint)
+			return codePoint < Other.codePoint;
+
+		if (Size != Other.Size)
+			return Size < Other.Size;
+
+		if (outlineSize != Other.outlineSize)
+			return outlineSize < Other.outlineSize;
+
+		if (Combined != Other.Combined)
+			return Other.Combined;
+
+		return Phase < Other.Phase;
+	}
+
+	unsigned int codePoint;
+	int Size;
+	int outlineSize;
+	bool Combined;
+	int Phase;
+};
+
+/*
+	Open addressing hash table from GlyphKey to Glyph*.
+
+	-Entries are stored contiguously, keys inline, so a lookup is a hash
+	 and (usually) one or two neighbouring entries.
+	-Linear probing, the capacity is a power of two and kept at least
+	 twice the number of entries, erased ones included.
+	-Find can run on other threads while one thread changes the table,
+	 inside a Reclaimer::Reader. An entry's key never changes once set:
+	 Erase only marks the entry, which is reused by the same key only.
+	 When too many entries are used, the live ones are copied to a new
+	 array that replaces the old one at once, and the old one is retired.
+
+	The table does not own the glyphs.
+*/
+class GlyphTable : public sf::NonCopyable
+{
+public:
+	explicit GlyphTable(Reclaimer& Retired);
+	~GlyphTable();
+
+	Glyph* Find(const GlyphKey& Key) const;
+
+	/*
+		Replaces the glyph if Key is already present.
+	*/
+	void Insert(const GlyphKey& Key, Glyph* Value);
+
+	/*
+		Returns the erased glyph, or 0 if Key was not found.
+	*/
+	Glyph* Erase(const GlyphKey& Key);
+
+	void Clear();
+
+	unsigned int getSize() const;
+
+	/*
+		For iterating over every glyph:
+		slots are 0 to getCapacity() - 1, empty slots return 0.
+	*/
+	unsigned int getCapacity() const;
+	Glyph* getSlot(unsigned int Slot) const;
+
+private:
+	struct Entry
+	{
+		GlyphKey Key;
+		/*
+			0 for empty entries, erasedGlyph (see GlyphTable.cpp)
+			for erased ones.
+			Set last, with atomicStore, so readers that see it see the key.
+		*/
+		Glyph* Value;
+	};
+	typedef std::vector<Entry> EntryList;
+	/*
+		The entries of one capacity, Mask + 1 of them.
+	*/
+	struct Block
+	{
+		unsigned int Mask;
+		EntryList Entries;
+	};
+
+	static unsigned int Hash(const GlyphKey& Key);
+	static void freeBlock(void* Owner, void* Object);
+
+	void Rebuild();
+
+	Reclaimer* myRetired;
+	/*
+		Replaced with atomicStore, 0 while the table is empty.
+	*/
+	Block* myBlock;
+	/*
+		Live entries, and entries used (live or erased).
+	*/
+	unsigned int mySize;
+	unsigned int myUsed;
+};
+
+}
+
+#endif
@@ -0,0 +1,175 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#ifndef SFTTF_GLYPH_WORKERS_HPP
+#define SFTTF_GLYPH_WORKERS_HPP
+
+#include <sfttf/GlyphTable.hpp>
+#include <sfttf/Rasterizer.hpp>
+#include <deque>
+#include <map>
+#include <vector>
+#include <SFML/System/Mutex.hpp>
+#include <SFML/System/NonCopyable.hpp>
+#include <SFML/System/Thread.hpp>
+
+namespace sfttf
+{
+
+class FontFace;
+
+/*
+	Threads that render glyphs in the background (see Font::setAsync).
+
+	Each worker has its own FreeType library and, for every font face it
+	is given glyphs of, its own Rasterizer. Workers only render: finished
+	glyphs wait in a list until the face collects them on the thread that
+	draws, which adds them to its cache and atlas.
+
+	Idle workers sleep until a glyph is queued for them (see Signal).
+*/
+class GlyphWorkers : public sf::NonCopyable
+{
+public:
+	GlyphWorkers();
+	~GlyphWorkers();
+
+	/*
+		Starts or stops workers until Count are running, those that
+		keep running are not interrupted. With 0, what was queued is
+		returned unrendered (see RenderedGlyph::Unstarted).
+	*/
+	void setCount(unsigned int Count);
+	unsigned int getCount() const;
+
+	/*
+		How many threads the machine runs at once, at least 1.
+	*/
+	static unsigned int getProcessorCount();
+
+	/*
+		Queues Key to be rendered for Face.
+		Returns false if there are no workers.
+	*/
+	bool Queue(FontFace* Face, const GlyphKey& Key);
+	/*
+		Moves the glyphs finished for Face to Done, the caller deletes them.
+	*/
+	void Collect(FontFace* Face, std::vector<RenderedGlyph*>& Done);
+	/*
+		Drops everything queued or finished for Face.
+		Glyphs being rendered still arrive afterwards.
+	*/
+	void cancelFace(FontFace* Face);
+	/*
+		Drops everything queued or finished for Face and waits until no
+		worker uses it, so it can be unloaded.
+	*/
+	void removeFace(FontFace* Face);
+
+private:
+	struct Job
+	{
+		FontFace* Face;
+		RenderedGlyph* Glyph;
+	};
+	typedef std::deque<Job> JobQueue;
+	typedef std::vector<Job> JobList;
+	typedef std::map<FontFace*, Rasterizer*> RasterizerMap;
+
+	/*
+		Wakes one waiting thread, or the next one to wait if none is.
+		SFML has no condition variables, this is the system's own
+		(a semaphore on Windows, a condition variable elsewhere).
+	*/
+	class Signal : public sf::NonCopyable
+	{
+	public:
+		Signal();
+		~Signal();
+
+		void Wait();
+		void Post();
+
+	private:
+		void* myImplementation;
+	};
+
+	class Worker : public sf::Thread
+	{
+	public:
+		explicit Worker(GlyphWorkers& Owner);
+
+		/*
+			Posted when the worker is Idle and there is something for it
+			to do (a glyph, faces to close, stopping).
+		*/
+		Signal Wake;
+		/*
+			Set by the worker before it waits on Wake, cleared by whoever
+			posts it. Guarded by the owner's mutex.
+		*/
+		bool Idle;
+
+		/*
+			Faces to close before the next job, set by removeFace.
+			Guarded by the owner's mutex.
+		*/
+		std::vector<FontFace*> Closing;
+		/*
+			Set by stopWorkers, guarded by the owner's mutex.
+		*/
+		bool Stopping;
+
+	private:
+		virtual void Run();
+		void closeFaces(RasterizerMap& Rasterizers);
+
+		GlyphWorkers* myOwner;
+	};
+	typedef std::vector<Worker*> WorkerList;
+
+	friend class Worker;
+
+	void stopWorkers(unsigned int Keep);
+	void wakeWorker(Worker* Target);
+	void takeJobs(FontFace* Face, std::vector<RenderedGlyph*>& Jobs);
+	static bool openRasterizer(FT_Library Library, const FontFace* Face, Rasterizer& Raster);
+	static bool renderGlyph(Rasterizer& Raster, RenderedGlyph& Rendered);
+
+	WorkerList myWorkers;
+	/*
+		Everything below is guarded by myMutex.
+	*/
+	sf::Mutex myMutex;
+	JobQueue myQueue;
+	JobList myDone;
+};
+
+}
+
+#endif
@@ -0,0 +1,71 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#ifndef SFTTF_MAPPED_FILE_HPP
+#define SFTTF_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+#include <SFML/System/NonCopyable.hpp>
+
+namespace sfttf
+{
+
+/*
+	A read-only memory mapped file.
+	The whole file is mapped, nothing is copied.
+*/
+class MappedFile : public sf::NonCopyable
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	/*
+		Closes any previously opened file first.
+	*/
+	bool Open(const std::string& Filename);
+	void Close();
+
+	bool isOpen() const;
+
+	const unsigned char* getData() const;
+	std::size_t getSize() const;
+
+private:
+	const unsigned char* myData;
+	std::size_t mySize;
+
+#ifdef _WIN32
+	void* myFile;
+	void* myMapping;
+#endif
+};
+
+}
+
+#endif
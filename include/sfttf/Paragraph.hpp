@@ -0,0 +1,154 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#ifndef SFTTF_PARAGRAPH_HPP
+#define SFTTF_PARAGRAPH_HPP
+
+#include <sfttf/Font.hpp>
+#include <sfttf/GlyphBatch.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/Rect.hpp>
+
+namespace sfttf
+{
+
+/*
+	A Paragraph is text broken into lines that fit a box, for messages,
+	descriptions, chat logs, ...
+
+	Lines are broken at spaces, and within words that are wider than
+	the box. New line characters always start a new line. Breaking only
+	measures the glyphs (see Font::getStringBounds), so the line count
+	and height of text that is never drawn cost no textures.
+
+	When the string changes, the lines before the one holding the first
+	changed character (and the one before it, a word may move back up)
+	are kept, only the rest is broken and placed again.
+
+	Like a TextRun, it takes the font's settings when it is created
+	(or in updateSettings) and is drawn with Window.Draw(Text). Its
+	position is the top left of the box, the first baseline being the
+	font's ascender below it.
+
+	Its glyphs stay in the font's cache while it exists, like a TextRun's.
+
+	The font must stay loaded while the paragraph exists.
+*/
+class Paragraph : public sf::Drawable
+{
+public:
+	enum Alignment
+	{
+		alignLeft,
+		alignCenter,
+		alignRight
+	};
+
+	/*
+		Width is the width of the box in pixels. With 0, lines are only
+		broken at new lines and aligned to the widest.
+		lineSpacing multiplies the font's distance between baselines.
+	*/
+	Paragraph(Font& theFont, const std::string& s, float Width, Alignment Align = alignLeft, float lineSpacing = 1.0f);
+	Paragraph(Font& theFont, const std::wstring& s, float Width, Alignment Align = alignLeft, float lineSpacing = 1.0f);
+
+	void setString(const std::string& s);
+	void setString(const std::wstring& s);
+
+	void setWidth(float Width);
+	void setAlignment(Alignment Align);
+	void setLineSpacing(float lineSpacing);
+
+	float getWidth() const;
+	Alignment getAlignment() const;
+	float getLineSpacing() const;
+
+	/*
+		Take the font's current settings again.
+	*/
+	void updateSettings();
+
+	/*
+		The lines as broken for the current string: how many there are,
+		and the index in the string of each line's first character.
+	*/
+	std::size_t getLineCount() const;
+	std::size_t getLineStart(std::size_t Line) const;
+
+	/*
+		Line count times the distance between baselines.
+	*/
+	float getHeight() const;
+
+	/*
+		Area covered by the glyphs, relative to the paragraph's position.
+		The glyphs are placed (and cached) for this.
+	*/
+	const sf::FloatRect& getBounds() const;
+
+protected:
+	virtual void Render(sf::RenderTarget& Target) const;
+
+private:
+	template <typename TIterator>
+	void setString(TIterator itCodePoint, const TIterator& itEnd);
+
+	void updateLines() const;
+	void updateLayout() const;
+	float getBoxWidth() const;
+
+	Font* myFont;
+	Font::Settings mySettings;
+	std::vector<uint32_t> myText;
+	float myWidth;
+	Alignment myAlignment;
+	float myLineSpacing;
+
+	/*
+		Lines and layout are updated on demand, which can happen in Render.
+		myLineText is the text myLines were broken for, myLinesDirty is
+		set when they must be broken again even if the text is the same.
+		The placement in myLayout is up to date for the first myPlacedLines
+		lines, with the box width myPlacedWidth.
+	*/
+	mutable std::vector<uint32_t> myLineText;
+	mutable Font::LineList myLines;
+	mutable bool myLinesDirty;
+	mutable Font::PlacedCharList myLayout;
+	mutable GlyphBatch myBatch;
+	mutable std::size_t myPlacedLines;
+	mutable float myPlacedWidth;
+	mutable bool myLayoutDirty;
+	mutable Font::LayoutGlyphs myGlyphs;
+};
+
+}
+
+#endif
@@ -0,0 +1,119 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#ifndef SFTTF_RASTERIZER_HPP
+#define SFTTF_RASTERIZER_HPP
+
+#include <sfttf/GlyphTable.hpp>
+#include <vector>
+#include <SFML/System/NonCopyable.hpp>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_STROKER_H
+
+namespace sfttf
+{
+
+class MappedFile;
+
+/*
+	The FreeType objects glyphs are rendered with: a face, its stroker
+	and the sizes last set on them.
+
+	FreeType objects must not be used by two threads at once, so every
+	thread that renders glyphs has its own rasterizer for each font face,
+	made from the same mapped file (see FontFace and GlyphWorkers).
+*/
+struct Rasterizer : public sf::NonCopyable
+{
+	Rasterizer();
+	~Rasterizer();
+
+	/*
+		Reads the face straight from the mapping, which must outlive it.
+		Only scalable fonts with a charmap are accepted.
+	*/
+	bool Open(FT_Library Library, const MappedFile& File, long faceIndex);
+	void Close();
+
+	/*
+		FT_Set_Pixel_Sizes and FT_Stroker_Set are only called when the size changes.
+	*/
+	bool setSize(int theSize);
+	void setOutlineSize(int theOutlineSize);
+
+	FT_Face Face;
+	FT_Stroker Stroker;
+	int Size;
+	int outlineSize;
+};
+
+/*
+	A glyph rendered by a Rasterizer, not yet in a font's cache.
+	Unlike FreeType's, the bitmap stays valid after the next glyph is rendered.
+*/
+struct RenderedGlyph : public sf::NonCopyable
+{
+	RenderedGlyph();
+
+	/*
+		Copies Source into Pixels, Bitmap then points to the copy.
+	*/
+	void setBitmap(const FT_Bitmap& Source);
+	/*
+		Bitmap points to Pixels, which was filled with Width * Height
+		8-bit coverage values.
+	*/
+	void setGrayBitmap(int Width, int Height);
+
+	GlyphKey Key;
+	/*
+		False until rendered, and if rendering failed.
+	*/
+	bool Rendered;
+	/*
+		Set if the workers were all stopped before rendering it
+		(see GlyphWorkers::setCount), it has not failed.
+	*/
+	bool Unstarted;
+
+	FT_Bitmap Bitmap;
+	std::vector<unsigned char> Pixels;
+	/*
+		Only for combined glyphs, see Glyph::Combined.
+	*/
+	std::vector<unsigned char> outlineShare;
+	int Left;
+	int Top;
+	int xAdvanceFixed;
+	unsigned int glyphIndex;
+};
+
+}
+
+#endif
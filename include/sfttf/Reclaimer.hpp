@@ -0,0 +1,100 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#ifndef SFTTF_RECLAIMER_HPP
+#define SFTTF_RECLAIMER_HPP
+
+#include <vector>
+#include <SFML/System/NonCopyable.hpp>
+
+namespace sfttf
+{
+
+/*
+	Deferred freeing of what readers may still be using without a lock
+	(see GlyphTable and Font::getStringWidth).
+
+	Readers hold a Reader while they look things up, and never wait.
+	The writer (one thread at a time, under the FontManager's lock)
+	unpublishes things first, then retires them. They are freed by a
+	later Reclaim, once every reader that could have seen them is done.
+
+	Two epochs: readers count themselves in the current one. Reclaim
+	frees what was retired before the last switch when nobody is left
+	reading in the previous epoch, then switches again if there is more
+	retired. A busy epoch only delays freeing, it never blocks anyone.
+*/
+class Reclaimer : public sf::NonCopyable
+{
+public:
+	typedef void (*FreeFunction)(void* Owner, void* Object);
+
+	Reclaimer();
+	/*
+		Frees everything retired, there must be no readers left.
+	*/
+	~Reclaimer();
+
+	class Reader : public sf::NonCopyable
+	{
+	public:
+		explicit Reader(Reclaimer& Owner);
+		~Reader();
+
+	private:
+		Reclaimer* myOwner;
+		long myEpoch;
+	};
+
+	/*
+		Free(Owner, Object) is called once no reader can be using Object.
+	*/
+	void Retire(FreeFunction Free, void* Owner, void* Object);
+	void Reclaim();
+
+private:
+	struct Retired
+	{
+		FreeFunction Free;
+		void* Owner;
+		void* Object;
+	};
+	typedef std::vector<Retired> RetiredList;
+
+	static void freeAll(RetiredList& List);
+
+	long myEpoch;
+	long myReaders[2];
+	/*
+		Retired during each epoch.
+	*/
+	RetiredList myRetired[2];
+};
+
+}
+
+#endif
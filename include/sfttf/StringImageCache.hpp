@@ -0,0 +1,130 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#ifndef SFTTF_STRING_IMAGE_CACHE_HPP
+#define SFTTF_STRING_IMAGE_CACHE_HPP
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <vector>
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/System/NonCopyable.hpp>
+
+namespace sfttf
+{
+
+/*
+	Everything an image of a whole string depends on.
+*/
+struct StringImageKey
+{
+	bool operator<(const StringImageKey& Other) const;
+
+	std::vector<unsigned int> Text;
+	bool Fill;
+	bool Outline;
+	int Size;
+	int outlineSize;
+	bool Kerning;
+	bool Combine;
+	bool Subpixel;
+	sf::Color Color;
+	sf::Color outlineColor;
+};
+
+/*
+	A string drawn once into its own image, see Font::drawCachedString.
+*/
+struct StringImage : public sf::NonCopyable
+{
+	sf::Image Image;
+	sf::Sprite Sprite;
+	/*
+		Top left corner of the image relative to the pen position.
+	*/
+	int Left;
+	int Top;
+};
+
+/*
+	Least recently used cache of string images, limited in bytes.
+*/
+class StringImageCache : public sf::NonCopyable
+{
+public:
+	StringImageCache();
+	~StringImageCache();
+
+	/*
+		Returns 0 if Key is not cached.
+	*/
+	StringImage* Find(const StringImageKey& Key);
+
+	/*
+		The cache takes ownership of Image.
+		Images larger than the whole budget are not kept: they are
+		deleted and Insert returns false.
+	*/
+	bool Insert(const StringImageKey& Key, StringImage* Image);
+
+	void Clear();
+
+	/*
+		0 means no limit.
+	*/
+	void setBudget(std::size_t Bytes);
+	std::size_t getBudget() const;
+	std::size_t getSize() const;
+
+private:
+	/*
+		Most recently used first.
+		Map keys never move, so the list can point at them.
+	*/
+	typedef std::list<const StringImageKey*> LruList;
+	struct Entry
+	{
+		StringImage* Image;
+		LruList::iterator itLru;
+	};
+	typedef std::map<StringImageKey, Entry> ImageMap;
+
+	void trim(std::size_t Budget);
+	static std::size_t getImageMemory(const StringImage* Image);
+
+	ImageMap myImages;
+	LruList myLru;
+	std::size_t mySize;
+	std::size_t myBudget;
+};
+
+}
+
+#endif
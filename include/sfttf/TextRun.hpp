@@ -0,0 +1,101 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#ifndef SFTTF_TEXT_RUN_HPP
+#define SFTTF_TEXT_RUN_HPP
+
+#include <sfttf/Font.hpp>
+#include <sfttf/GlyphBatch.hpp>
+#include <string>
+#include <vector>
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/Rect.hpp>
+
+namespace sfttf
+{
+
+/*
+	A TextRun is a string laid out once, for text that is drawn often
+	but rarely changes (labels, menus, ...).
+
+	It takes the font's settings when it is created (or in updateSettings),
+	later changes to the font's settings do not affect it.
+	Drawing it costs nothing per character: it is drawn with
+	Window.Draw(Run) at its position (SetPosition), which is the pen
+	position on the baseline, like the X, Y of Font::drawString.
+
+	The run's glyphs stay in the font's cache while it exists: budgets
+	do not evict them (they still count in the cache size). The layout
+	is redone automatically, the next time the run is drawn, after
+	clearCache, or when glyphs it was laid out with placeholders for
+	arrive (see Font::setAsync).
+
+	The font must stay loaded while the run exists.
+*/
+class TextRun : public sf::Drawable
+{
+public:
+	TextRun(Font& theFont, const std::string& s);
+	TextRun(Font& theFont, const std::wstring& s);
+
+	void setString(const std::string& s);
+	void setString(const std::wstring& s);
+
+	/*
+		Take the font's current settings again.
+	*/
+	void updateSettings();
+
+	/*
+		Area covered by the glyphs, relative to the run's position.
+	*/
+	const sf::FloatRect& getBounds() const;
+
+protected:
+	virtual void Render(sf::RenderTarget& Target) const;
+
+private:
+	template <typename TIterator>
+	void setString(TIterator itCodePoint, const TIterator& itEnd);
+
+	void updateLayout() const;
+
+	Font* myFont;
+	Font::Settings mySettings;
+	std::vector<uint32_t> myText;
+
+	/*
+		The layout is built on demand, which can happen in Render.
+	*/
+	mutable GlyphBatch myBatch;
+	mutable Font::LayoutGlyphs myGlyphs;
+	mutable bool myDirty;
+};
+
+}
+
+#endif
@@ -0,0 +1,213 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#include <sfttf/DistanceFieldProgram.hpp>
+#include <cstdlib>
+#include <SFML/Window/OpenGL.hpp>
+
+#if defined(_WIN32)
+#elif defined(__APPLE__)
+#include <dlfcn.h>
+#else
+#include <GL/glx.h>
+#endif
+
+/*
+	OpenGL 2.0 entry points are not in Windows' gl.h (1.1),
+	so they are declared here and loaded at run time.
+*/
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+#ifndef GL_FRAGMENT_SHADER
+#define GL_FRAGMENT_SHADER	0x8B30
+#define GL_COMPILE_STATUS	0x8B81
+#define GL_LINK_STATUS		0x8B82
+#endif
+
+namespace
+{
+	typedef GLuint (APIENTRY* CreateShaderProc)(GLenum Type);
+	typedef void (APIENTRY* ShaderSourceProc)(GLuint Shader, GLsizei Count, const char** Strings, const GLint* Lengths);
+	typedef void (APIENTRY* CompileShaderProc)(GLuint Shader);
+	typedef void (APIENTRY* GetShaderivProc)(GLuint Shader, GLenum Name, GLint* Value);
+	typedef void (APIENTRY* DeleteShaderProc)(GLuint Shader);
+	typedef GLuint (APIENTRY* CreateProgramProc)();
+	typedef void (APIENTRY* AttachShaderProc)(GLuint Program, GLuint Shader);
+	typedef void (APIENTRY* LinkProgramProc)(GLuint Program);
+	typedef void (APIENTRY* GetProgramivProc)(GLuint Program, GLenum Name, GLint* Value);
+	typedef void (APIENTRY* DeleteProgramProc)(GLuint Program);
+	typedef void (APIENTRY* UseProgramProc)(GLuint Program);
+	typedef GLint (APIENTRY* GetUniformLocationProc)(GLuint Program, const char* Name);
+	typedef void (APIENTRY* Uniform1fProc)(GLint Location, GLfloat Value);
+	typedef void (APIENTRY* Uniform4fProc)(GLint Location, GLfloat X, GLfloat Y, GLfloat Z, GLfloat W);
+
+	CreateShaderProc glCreateShaderPtr = 0;
+	ShaderSourceProc glShaderSourcePtr = 0;
+	CompileShaderProc glCompileShaderPtr = 0;
+	GetShaderivProc glGetShaderivPtr = 0;
+	DeleteShaderProc glDeleteShaderPtr = 0;
+	CreateProgramProc glCreateProgramPtr = 0;
+	AttachShaderProc glAttachShaderPtr = 0;
+	LinkProgramProc glLinkProgramPtr = 0;
+	GetProgramivProc glGetProgramivPtr = 0;
+	DeleteProgramProc glDeleteProgramPtr = 0;
+	UseProgramProc glUseProgramPtr = 0;
+	GetUniformLocationProc glGetUniformLocationPtr = 0;
+	Uniform1fProc glUniform1fPtr = 0;
+	Uniform4fProc glUniform4fPtr = 0;
+
+	template <typename TProc>
+	bool loadProc(TProc& Proc, const char* Name)
+	{
+#if defined(_WIN32)
+		Proc = reinterpret_cast<TProc>(wglGetProcAddress(Name));
+#elif defined(__APPLE__)
+		Proc = reinterpret_cast<TProc>(dlsym(RTLD_DEFAULT, Name));
+#else
+		Proc = reinterpret_cast<TProc>(glXGetProcAddressARB(reinterpret_cast<const GLubyte*>(Name)));
+#endif
+		return 0 != Proc;
+	}
+
+	/*
+		Smoothing is half a screen pixel of field, whatever the scale.
+		The outline is drawn over the fill, as with bitmap glyphs.
+	*/
+	const char* fragmentSource =
+		"uniform sampler2D Texture;\n"
+		"uniform vec4 outlineColor;\n"
+		"uniform float outlineWidth;\n"
+		"void main()\n"
+		"{\n"
+		"	float Distance = texture2D(Texture, gl_TexCoord[0].xy).a;\n"
+		"	float Smoothing = 0.5 * fwidth(Distance);\n"
+		"	float fillAlpha = gl_Color.a * smoothstep(0.5 - Smoothing, 0.5 + Smoothing, Distance);\n"
+		"	float outlineAlpha = 0.0;\n"
+		"	if (outlineWidth > 0.0)\n"
+		"		outlineAlpha = outlineColor.a * (smoothstep(0.5 - outlineWidth - Smoothing, 0.5 - outlineWidth + Smoothing, Distance) -\n"
+		"			smoothstep(0.5 + outlineWidth - Smoothing, 0.5 + outlineWidth + Smoothing, Distance));\n"
+		"	float Alpha = outlineAlpha + fillAlpha * (1.0 - outlineAlpha);\n"
+		"	vec3 Color = outlineColor.rgb * outlineAlpha + gl_Color.rgb * fillAlpha * (1.0 - outlineAlpha);\n"
+		"	gl_FragColor = vec4(Color / max(Alpha, 0.001), Alpha);\n"
+		"}\n";
+}
+
+/*
+	The program is never deleted, it is shared by every font for the
+	life of the program.
+*/
+const sfttf::DistanceFieldProgram* sfttf::DistanceFieldProgram::getProgram()
+{
+	static DistanceFieldProgram* Program = 0;
+	static bool Tried = false;
+	if (!Tried)
+	{
+		Tried = true;
+		DistanceFieldProgram* newProgram = new DistanceFieldProgram;
+		if (newProgram->Load())
+			Program = newProgram;
+		else
+			delete newProgram;
+	}
+	return Program;
+}
+
+void sfttf::DistanceFieldProgram::Bind(const sf::Color& outlineColor, float outlineWidth) const
+{
+	glUseProgramPtr(myProgram);
+	glUniform4fPtr(myOutlineColor,
+		outlineColor.r / 255.0f,
+		outlineColor.g / 255.0f,
+		outlineColor.b / 255.0f,
+		outlineColor.a / 255.0f);
+	glUniform1fPtr(myOutlineWidth, outlineWidth);
+}
+
+void sfttf::DistanceFieldProgram::Unbind()
+{
+	glUseProgramPtr(0);
+}
+
+sfttf::DistanceFieldProgram::DistanceFieldProgram() : myProgram(0),
+													  myOutlineColor(-1),
+													  myOutlineWidth(-1)
+{
+}
+
+bool sfttf::DistanceFieldProgram::Load()
+{
+	const char* Version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+	if (!Version || std::atoi(Version) < 2)
+		return false;
+
+	if (!loadProc(glCreateShaderPtr, "glCreateShader") ||
+		!loadProc(glShaderSourcePtr, "glShaderSource") ||
+		!loadProc(glCompileShaderPtr, "glCompileShader") ||
+		!loadProc(glGetShaderivPtr, "glGetShaderiv") ||
+		!loadProc(glDeleteShaderPtr, "glDeleteShader") ||
+		!loadProc(glCreateProgramPtr, "glCreateProgram") ||
+		!loadProc(glAttachShaderPtr, "glAttachShader") ||
+		!loadProc(glLinkProgramPtr, "glLinkProgram") ||
+		!loadProc(glGetProgramivPtr, "glGetProgramiv") ||
+		!loadProc(glDeleteProgramPtr, "glDeleteProgram") ||
+		!loadProc(glUseProgramPtr, "glUseProgram") ||
+		!loadProc(glGetUniformLocationPtr, "glGetUniformLocation") ||
+		!loadProc(glUniform1fPtr, "glUniform1f") ||
+		!loadProc(glUniform4fPtr, "glUniform4f"))
+		return false;
+
+	GLint Result = GL_FALSE;
+	const GLuint Shader = glCreateShaderPtr(GL_FRAGMENT_SHADER);
+	glShaderSourcePtr(Shader, 1, &fragmentSource, 0);
+	glCompileShaderPtr(Shader);
+	glGetShaderivPtr(Shader, GL_COMPILE_STATUS, &Result);
+	if (GL_TRUE != Result)
+	{
+		glDeleteShaderPtr(Shader);
+		return false;
+	}
+
+	myProgram = glCreateProgramPtr();
+	glAttachShaderPtr(myProgram, Shader);
+	glLinkProgramPtr(myProgram);
+	/*
+		The program keeps the shader alive.
+	*/
+	glDeleteShaderPtr(Shader);
+	glGetProgramivPtr(myProgram, GL_LINK_STATUS, &Result);
+	if (GL_TRUE != Result)
+	{
+		glDeleteProgramPtr(myProgram);
+		myProgram = 0;
+		return false;
+	}
+	myOutlineColor = glGetUniformLocationPtr(myProgram, "outlineColor");
+	myOutlineWidth = glGetUniformLocationPtr(myProgram, "outlineWidth");
+	return true;
+}
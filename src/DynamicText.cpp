@@ -0,0 +1,118 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#include <sfttf/DynamicText.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+
+sfttf::DynamicText::DynamicText(Font& theFont, const std::string& s) : myFont(&theFont),
+																		   mySettings(theFont.mySettings),
+																		   myBatch(theFont.getAtlas()),
+																		   myGlyphs(theFont),
+																		   myDirty(true)
+{
+	setString(s.begin(), s.end());
+}
+
+sfttf::DynamicText::DynamicText(Font& theFont, const std::wstring& s) : myFont(&theFont),
+																			mySettings(theFont.mySettings),
+																			myBatch(theFont.getAtlas()),
+																			myGlyphs(theFont),
+																			myDirty(true)
+{
+	setString(s.begin(), s.end());
+}
+
+void sfttf::DynamicText::setString(const std::string& s)
+{
+	setString(s.begin(), s.end());
+}
+
+void sfttf::DynamicText::setString(const std::wstring& s)
+{
+	setString(s.begin(), s.end());
+}
+
+/*
+	Nothing can be reused with other settings.
+*/
+void sfttf::DynamicText::updateSettings()
+{
+	mySettings = myFont->mySettings;
+	myLayoutText.clear();
+	myLayout.clear();
+	myDirty = true;
+}
+
+const sf::FloatRect& sfttf::DynamicText::getBounds() const
+{
+	Font::UseLock Lock(*myFont->myManager);
+	updateLayout();
+	return myBatch.getBounds();
+}
+
+void sfttf::DynamicText::Render(sf::RenderTarget& Target) const
+{
+	Font::UseLock Lock(*myFont->myManager);
+	updateLayout();
+	if (!myBatch.isEmpty())
+		Target.Draw(myBatch);
+}
+
+/*
+	Only stores the text, it is compared with the last layout's
+	when the layout is next needed.
+*/
+template <typename TIterator>
+void sfttf::DynamicText::setString(TIterator itCodePoint, const TIterator& itEnd)
+{
+	myText.clear();
+	for (; itEnd != itCodePoint; ++itCodePoint)
+		myText.push_back(static_cast<uint32_t>(*itCodePoint));
+}
+
+/*
+	The placed glyphs are held (see Font::LayoutGlyphs). When the layout
+	is out of date anyway, everything is placed again.
+*/
+void sfttf::DynamicText::updateLayout() const
+{
+	if (!myGlyphs.isCurrent())
+	{
+		myLayoutText.clear();
+		myLayout.clear();
+		myDirty = true;
+	}
+	if (!myDirty && myLayoutText == myText)
+		return;
+
+	const bool Kept = !myLayout.empty();
+	myGlyphs.beginLayout();
+	myFont->updateRun(mySettings, myLayoutText, myText, myLayout, myBatch);
+	myGlyphs.endLayout(myLayout, Kept);
+	myLayoutText = myText;
+	myDirty = false;
+}
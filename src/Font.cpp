@@ -1,656 +1,1549 @@
-/**********************************************************************
-Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
-All rights reserved.
-
-Redistribution and use in source and binary forms, with or without
-modification, are permitted provided that the following conditions
-are met:
-
-* Redistributions of source code must retain the above copyright
-notice, this list of conditions and the following disclaimer.
-
-* Redistributions in binary form must reproduce the above copyright
-notice, this list of conditions and the following disclaimer in the
-documentation and/or other materials provided with the distribution.
-
-THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
-"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
-LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
-A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
-OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
-SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
-LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
-DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
-THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
-(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
-OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-**********************************************************************/
-#include <sfttf/Font.hpp>
-#include <sfttf/Glyph.hpp>
-#include <cassert>
-#include <cwctype>
-
-/*
-	TODO:
-	There is a small bug with kerning.
-	When kerning is enabled, you can see rendered text 'jump' the first time
-	it is rendered.
-*/
-
-/*
-	NOTES:
-	-In this code, a 'char' is a combination of a filled glyph and/or outline
-	-A glyph is either a regular filled glyph or an outline
-	-Functions are in the same order as they are in the header
-*/
-
-bool sfttf::Font::cacheChar(uint32_t codePoint)
-{
-	bool Result = true;
-	if (mySettings.Fill && !cacheGlyph(codePoint))
-		Result = false;
-
-	if (mySettings.Outline && 0 != mySettings.outlineSize && !cacheGlyphOutline(codePoint))
-		Result = false;
-
-	return Result;
-}
-
-bool sfttf::Font::cacheString(const std::string& s)
-{
-	return cacheString(s.begin(), s.end());
-}
-
-bool sfttf::Font::cacheString(const std::wstring& s)
-{
-	return cacheString(s.begin(), s.end());
-}
-
-void sfttf::Font::clearCache()
-{
-/*
-	TODO: Which is fastest?
-*/
-#if 0
-	GlyphCache::iterator itGlyph(myGlyphs.begin());
-	GlyphCache::iterator itEnd(myGlyphs.end());
-	for (; itEnd != itGlyph; ++itGlyph)
-		delete itGlyph->second;
-
-	myGlyphs.clear();
-
-	itGlyph = myGlyphOutlines.begin();
-	itEnd = myGlyphOutlines.end();
-	for (; itEnd != itGlyph; ++itGlyph)
-		delete itGlyph->second;
-
-	myGlyphOutlines.clear();
-#else
-	while (!myGlyphs.empty())
-	{
-		delete myGlyphs.begin()->second;
-		myGlyphs.erase(myGlyphs.begin());
-	}
-	while (!myGlyphOutlines.empty())
-	{
-		delete myGlyphOutlines.begin()->second;
-		myGlyphOutlines.erase(myGlyphOutlines.begin());
-	}
-#endif
-}
-
-/*
-	If Fill is true, the filled glyph will be cached/drawn.
-*/
-void sfttf::Font::setFill(bool Fill)
-{
-	mySettings.Fill = Fill;
-}
-
-/*
-	If Outline is true, the glyph outline will be cached/drawn
-*/
-void sfttf::Font::setOutline(bool Outline)
-{
-	mySettings.Outline = Outline;
-}
-
-/*
-When setSize is called, mySize is simply changed.
-
-myFreeTypeSize is the size last set with FT_Set_Pixel_Sizes.
-To avoid needlessly calling FT_Set_Pixel_Sizes, it is called
-only if mySize != myFreeTypeSize, when a glyph is cached.
-*/
-void sfttf::Font::setSize(int Size)
-{
-	mySettings.Size = std::abs(Size);
-}
-
-void sfttf::Font::setOutlineSize(int Size)
-{
-	mySettings.outlineSize = std::abs(Size);
-}
-
-void sfttf::Font::setColor(const sf::Color& Color)
-{
-	mySettings.Color = Color;
-}
-
-void sfttf::Font::setOutlineColor(const sf::Color& Color)
-{
-	mySettings.outlineColor = Color;
-}
-
-void sfttf::Font::setKerning(bool Kerning)
-{
-	mySettings.Kerning = Kerning;
-}
-
-bool sfttf::Font::drawChar(uint32_t codePoint, float X, float Y)
-{
-	sfttf::Glyph* filledGlyph = 0;
-	sfttf::Glyph* outlinedGlyph = 0;
-	if (cacheChar(codePoint))
-	{
-		if (mySettings.Fill)
-		{
-			filledGlyph = getGlyph(codePoint);
-			if (!filledGlyph->Draw(X + static_cast<float>(filledGlyph->bitmapLeft), Y - static_cast<float>(filledGlyph->bitmapTop), mySettings.Color))
-				return false;
-		}
-		if (mySettings.Outline && 0 != mySettings.outlineSize)
-		{
-			outlinedGlyph = getGlyphOutline(codePoint);
-			if (!outlinedGlyph->Draw(X + static_cast<float>(outlinedGlyph->bitmapLeft), Y - static_cast<float>(outlinedGlyph->bitmapTop), mySettings.outlineColor))
-				return false;
-		}
-	}
-	return filledGlyph || outlinedGlyph;
-}
-
-bool sfttf::Font::drawString(const std::string& s, float X, float Y)
-{
-	return drawString(s.begin(), s.end(), X, Y);
-}
-
-bool sfttf::Font::drawString(const std::wstring& s, float X, float Y)
-{
-	return drawString(s.begin(), s.end(), X, Y);
-}
-
-unsigned int sfttf::Font::getCharWidth(uint32_t codePoint)
-{
-	Glyph* g = 0;
-	if (cacheChar(codePoint))
-	{
-		/*
-			Prefer outline as it should be larger
-		*/
-		if (mySettings.Outline && 0 != mySettings.outlineSize)
-			g = getGlyphOutline(codePoint);
-		else if (mySettings.Fill)
-			g = getGlyph(codePoint);
-	}
-	return g ? g->glyphWidth : 0;
-}
-
-unsigned int sfttf::Font::getCharHeight(uint32_t codePoint)
-{
-	Glyph* g = 0;
-	if (cacheChar(codePoint))
-	{
-		/*
-			Prefer outline as it should be larger
-		*/
-		if (mySettings.Outline && 0 != mySettings.outlineSize)
-			g = getGlyphOutline(codePoint);
-		else if (mySettings.Fill)
-			g = getGlyph(codePoint);
-	}
-	return g ? g->glyphHeight : 0;
-}
-
-unsigned int sfttf::Font::getStringWidth(const std::string& s)
-{
-	return getStringWidth(s.begin(), s.end());
-}
-
-unsigned int sfttf::Font::getStringWidth(const std::wstring& s)
-{
-	return getStringWidth(s.begin(), s.end());
-}
-
-unsigned int sfttf::Font::getStringHeight(const std::string& s)
-{
-	return getStringHeight(s.begin(), s.end());
-}
-
-unsigned int sfttf::Font::getStringHeight(const std::wstring& s)
-{
-	return getStringHeight(s.begin(), s.end());
-}
-
-bool sfttf::Font::getFill() const
-{
-	return mySettings.Fill;
-}
-
-bool sfttf::Font::getOutline() const
-{
-	return mySettings.Outline;
-}
-
-int sfttf::Font::getSize() const
-{
-	return mySettings.Size;
-}
-
-int sfttf::Font::getOutlineSize() const
-{
-	return mySettings.outlineSize;
-}
-
-bool sfttf::Font::getKerning() const
-{
-	return mySettings.Kerning;
-}
-
-void sfttf::Font::Push()
-{
-	mySettingsStack.push_back(mySettings);
-}
-
-void sfttf::Font::Pop()
-{
-	if (mySettingsStack.empty())
-		return;
-
-	mySettings = mySettingsStack.back();
-	mySettingsStack.pop_back();
-}
-
-sfttf::Font::Font(sf::RenderWindow* Window, FT_Library FreeType) : myWindow(Window),
-																   myFreeType(FreeType),
-																   myFace(0),
-																   myStroker(0),
-																   myFreeTypeSize(0),
-																   myFreeTypeOutlineSize(0),
-																   myHaveKerning(false)
-{
-}
-
-sfttf::Font::~Font()
-{
-	Deinitialize();
-}
-
-bool sfttf::Font::Initialize(const std::string& Filename)
-{
-	if (0 != FT_New_Face(myFreeType, Filename.c_str(), 0, &myFace))
-		return false;
-
-	/*
-	Only scalable Unicode fonts (I have not tested anything else)
-	*/
-	if (!myFace->charmap || !FT_IS_SCALABLE(myFace))
-	{
-		Deinitialize();
-		return false;
-	}
-	if (0 != FT_Stroker_New(reinterpret_cast<FT_Memory>(myFreeType), &myStroker))
-	{
-		Deinitialize();
-		return false;
-	}
-	if (FT_HAS_KERNING(myFace))
-		myHaveKerning = true;
-
-	return true;
-}
-
-void sfttf::Font::Deinitialize()
-{
-	if (0 != myStroker)
-		FT_Stroker_Done(myStroker);
-
-	if (0 != myFace)
-		assert(0 == FT_Done_Face(myFace));
-
-	myFace = 0;
-}
-
-/*
-This is the function that actually calls FT_Set_Pixel_Sizes
-*/
-bool sfttf::Font::updateSize()
-{
-	if (mySettings.Size != myFreeTypeSize)
-	{
-		if (0 != FT_Set_Pixel_Sizes(myFace, mySettings.Size, 0))
-			return false;
-
-		myFreeTypeSize = mySettings.Size;
-	}
-	return true;
-}
-
-void sfttf::Font::updateOutlineSize()
-{
-	if (mySettings.outlineSize != myFreeTypeOutlineSize)
-	{
-		FT_Stroker_Set(myStroker,
-			64 * mySettings.outlineSize,
-			FT_STROKER_LINECAP_ROUND,
-			FT_STROKER_LINEJOIN_ROUND,
-			0);
-	}
-}
-
-bool sfttf::Font::cacheGlyph(uint32_t codePoint)
-{
-	if (0 == mySettings.Size)
-		return false;
-
-	if (isGlyphCached(codePoint))
-		return true;
-
-	if (!updateSize())
-		return false;
-
-	FT_UInt glyphIndex = FT_Get_Char_Index(myFace, codePoint);
-	/*
-	You have two choices for glyphIndex == 0 (code point not in font):
-	-Return false
-	-Ignore it. This will typically show a 'box'
-
-	if (0 == glyphIndex)
-		return false;
-	*/
-
-	if (0 != FT_Load_Glyph(myFace, glyphIndex, FT_LOAD_RENDER))
-		return false;
-
-	Glyph* newGlyph = new Glyph;
-	FT_Bitmap& Bitmap = myFace->glyph->bitmap;
-	if (!newGlyph->renderTexture(Bitmap))
-	{
-		delete newGlyph;
-		return false;
-	}
-	newGlyph->Setup(Bitmap,
-		myWindow,
-		myFace->glyph->bitmap_left,
-		myFace->glyph->bitmap_top,
-		myFace->glyph->metrics.horiAdvance >> 6,
-		glyphIndex,
-		mySettings.Size,
-		0);
-
-	myGlyphs.insert(GlyphCache::value_type(codePoint, newGlyph));
-	return true;
-}
-
-bool sfttf::Font::isGlyphCached(uint32_t codePoint)
-{
-	return 0 != getGlyph(codePoint);
-}
-
-bool sfttf::Font::cacheGlyphOutline(uint32_t codePoint)
-{
-	if (0 == mySettings.Size || 0 == mySettings.outlineSize)
-		return false;
-
-	if (isGlyphOutlineCached(codePoint))
-		return true;
-
-	if (!updateSize())
-		return false;
-
-	updateOutlineSize();
-	FT_UInt glyphIndex = FT_Get_Char_Index(myFace, codePoint);
-	/*
-	You have two choices for glyphIndex == 0 (code point not in font):
-	-Return false
-	-Ignore it. This will typically show a 'box'
-
-	if (0 == glyphIndex)
-		return false;
-	*/
-
-	if (0 != FT_Load_Glyph(myFace, glyphIndex, FT_LOAD_NO_BITMAP))
-		return false;
-
-	if (!(myFace->glyph->format & FT_GLYPH_FORMAT_OUTLINE))
-		return false;
-
-	FT_Glyph Glyph = 0;
-	if (0 != FT_Get_Glyph(myFace->glyph, &Glyph))
-		return false;
-
-	/*
-	This will insure FT_Done_Glyph is called.
-	FT_Glyph is a pointer.
-	FT_Glyph_Stroke/FT_Glyph_To_Bitmap will actually change where
-	the FT_Glyph points, and (optionally) call FT_Done_Glyph on the old one.
-	This is why FreeGlyph must take the address of the FT_Glyph.
-	Otherwise, we could leak or FT_Done_Glyph could be called twice (crash).
-	*/
-	FreeGlyph f(&Glyph);
-	if (0 != FT_Glyph_Stroke(&Glyph, myStroker, 1))
-		return false;
-
-	if (0 != FT_Glyph_To_Bitmap(&Glyph, FT_RENDER_MODE_NORMAL, 0, 1))
-		return false;
-
-	/*
-	See the FreeType docs/demos.
-	*/
-	FT_BitmapGlyph bitmapGlyph = reinterpret_cast<FT_BitmapGlyph>(Glyph);
-	sfttf::Glyph* newGlyphOutline = new sfttf::Glyph;
-	FT_Bitmap& Bitmap = bitmapGlyph->bitmap;
-	if (!newGlyphOutline->renderTexture(Bitmap))
-	{
-		delete newGlyphOutline;
-		return false;
-	}
-	newGlyphOutline->Setup(Bitmap,
-		myWindow,
-		bitmapGlyph->left,
-		bitmapGlyph->top,
-		Glyph->advance.x >> 16,
-		glyphIndex,
-		mySettings.Size,
-		mySettings.outlineSize);
-
-	myGlyphOutlines.insert(GlyphCache::value_type(codePoint, newGlyphOutline));
-	return true;
-}
-
-bool sfttf::Font::isGlyphOutlineCached(uint32_t codePoint)
-{
-	return 0 != getGlyphOutline(codePoint);
-}
-
-sfttf::Glyph* sfttf::Font::getGlyph(uint32_t codePoint)
-{
-	GlyphRange Range(myGlyphs.equal_range(codePoint));
-	GlyphCache::iterator itGlyph(Range.first);
-	const GlyphCache::const_iterator itEnd(Range.second);
-
-	for (; itEnd != itGlyph; ++itGlyph)
-	{
-		Glyph* g = itGlyph->second;
-		if (g->Size == mySettings.Size)
-			return g;
-	}
-	return 0;
-}
-
-sfttf::Glyph* sfttf::Font::getGlyphOutline(uint32_t codePoint)
-{
-	GlyphRange Range(myGlyphOutlines.equal_range(codePoint));
-	GlyphCache::iterator itGlyphOutline(Range.first);
-	const GlyphCache::const_iterator itEnd(Range.second);
-
-	for (; itEnd != itGlyphOutline; ++itGlyphOutline)
-	{
-		Glyph* g = itGlyphOutline->second;
-		if (g->Size == mySettings.Size && g->outlineSize == mySettings.outlineSize)
-			return g;
-	}
-	return 0;
-}
-
-sfttf::Glyph* sfttf::Font::drawChar(uint32_t codePoint, float& penX, float& penY, Glyph* previousGlyph)
-{
-	sfttf::Glyph* filledGlyph = 0;
-	sfttf::Glyph* outlinedGlyph = 0;
-	if (cacheChar(codePoint))
-	{
-		if (mySettings.Fill)
-			filledGlyph = getGlyph(codePoint);
-
-		if (mySettings.Outline && 0 != mySettings.outlineSize)
-			outlinedGlyph = getGlyphOutline(codePoint);
-
-		int kerningX = 0;
-		int kerningY = 0;
-		if (filledGlyph)
-			getKerning(previousGlyph, filledGlyph, &kerningX, &kerningY);
-		else if (outlinedGlyph)
-			getKerning(previousGlyph, outlinedGlyph, &kerningX, &kerningY);
-
-		penX += static_cast<float>(kerningX);
-		penY += static_cast<float>(kerningY);
-		if (filledGlyph)
-		{
-			if (!filledGlyph->Draw(penX + static_cast<float>(filledGlyph->bitmapLeft), penY - static_cast<float>(filledGlyph->bitmapTop), mySettings.Color))
-				return 0;
-		}
-		if (outlinedGlyph)
-		{
-			if (!outlinedGlyph->Draw(penX + static_cast<float>(outlinedGlyph->bitmapLeft), penY - outlinedGlyph->bitmapTop, mySettings.outlineColor))
-				return 0;
-		}
-
-		if (outlinedGlyph)
-			penX += static_cast<float>(outlinedGlyph->xAdvance);
-		else if (filledGlyph)
-			penX += static_cast<float>(filledGlyph->xAdvance);
-	}
-	return outlinedGlyph ? outlinedGlyph : filledGlyph;
-}
-
-/*
-	This gets the relative offsets for kerning.
-*/
-void sfttf::Font::getKerning(Glyph* leftGlyph, Glyph* rightGlyph, int* offsetX, int* offsetY)
-{
-	FT_Vector Delta;
-	if (offsetX)
-		*offsetX = 0;
-
-	if (offsetY)
-		*offsetY = 0;
-
-	if (myHaveKerning && mySettings.Kerning && leftGlyph && rightGlyph)
-	{
-		if (0 == FT_Get_Kerning(myFace, leftGlyph->glyphIndex, rightGlyph->glyphIndex, FT_KERNING_DEFAULT, &Delta))
-		{
-			if (offsetX)
-				*offsetX = Delta.x >> 6;
-
-			if (offsetY)
-				*offsetY = Delta.y >> 6;
-		}
-	}
-}
-
-template <typename TIterator>
-bool sfttf::Font::cacheString(TIterator itCodePoint, const TIterator& itEnd)
-{
-	bool Result = false;
-	for (; itEnd != itCodePoint; ++itCodePoint)
-	{
-		if (!cacheChar(*itCodePoint))
-			Result = false;
-	}
-	return Result;
-}
-
-template <typename TIterator>
-bool sfttf::Font::drawString(TIterator itCodePoint, const TIterator& itEnd, float X, float Y)
-{
-	float penX = X;
-	float penY = Y;
-	bool Result = true;
-	uint32_t codePoint = 0;
-	Glyph* g = 0;
-	Glyph* previousGlyph = 0;
-	for (; itEnd != itCodePoint; ++itCodePoint)
-	{
-		codePoint = *itCodePoint;
-		g = drawChar(codePoint, penX, penY, previousGlyph);
-		if (0 == g)
-			Result = false;
-
-		previousGlyph = g;
-	}
-	return Result;
-}
-
-template <typename TIterator>
-unsigned int sfttf::Font::getStringWidth(TIterator itCodePoint, const TIterator& itEnd)
-{
-	uint32_t codePoint = 0;
-	unsigned int Width = 0;
-	Glyph* g = 0;
-	Glyph* previousGlyph = 0;
-	for (; itEnd != itCodePoint; ++itCodePoint)
-	{
-		codePoint = *itCodePoint;
-		if (!cacheChar(codePoint))
-			continue;
-
-		if (mySettings.Outline && 0 != mySettings.outlineSize)
-			g = getGlyphOutline(codePoint);
-		else
-			g = getGlyph(codePoint);
-
-		int kerningX;
-		getKerning(previousGlyph, g, &kerningX, 0);
-
-		Width += g->xAdvance + kerningX;
-		previousGlyph = g;
-	}
-	if (g)
-	{
-		Width -= g->xAdvance;
-		Width += g->glyphWidth;
-	}
-	return Width;
-}
-
-template <typename TIterator>
-unsigned int sfttf::Font::getStringHeight(TIterator itCodePoint, const TIterator& itEnd)
-{
-	uint32_t codePoint = 0;
-	Glyph* g = 0;
-	unsigned int Height = 0;
-	for (; itEnd != itCodePoint; ++itCodePoint)
-	{
-		codePoint = *itCodePoint;
-		if (!cacheChar(codePoint))
-			continue;
-
-		if (mySettings.Outline && 0 != mySettings.outlineSize)
-			g = getGlyphOutline(codePoint);
-		else
-			g = getGlyph(codePoint);
-
-		if (static_cast<unsigned int>(g->glyphHeight) > Height)
-			Height = g->glyphHeight;
-	}
-	return Height;
-}
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#include <sfttf/Font.hpp>
+#include <sfttf/DistanceFieldProgram.hpp>
+#include <sfttf/Glyph.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cwctype>
+
+/*
+	TODO:
+	There is a small bug with kerning.
+	When kerning is enabled, you can see rendered text 'jump' the first time
+	it is rendered.
+*/
+
+/*
+	NOTES:
+	-In this code, a 'char' is a combination of a filled glyph and/or outline
+	-A glyph is either a regular filled glyph or an outline
+	-Functions are in the same order as they are in the header
+*/
+
+bool sfttf::Font::cacheChar(uint32_t codePoint)
+{
+	FontManager::UseLock Lock(*myManager);
+	myFontFace->beginUse();
+	return cachePhases(codePoint, false);
+}
+
+bool sfttf::Font::cacheString(const std::string& s)
+{
+	return cacheString(s.begin(), s.end());
+}
+
+bool sfttf::Font::cacheString(const std::wstring& s)
+{
+	return cacheString(s.begin(), s.end());
+}
+
+void sfttf::Font::clearCache()
+{
+	FontManager::UseLock Lock(*myManager);
+	myBatch.Clear();
+	myStringImages.Clear();
+	myFontFace->clearCache();
+}
+
+void sfttf::Font::setCacheBudget(std::size_t Bytes)
+{
+	FontManager::UseLock Lock(*myManager);
+	myFontFace->setCacheBudget(Bytes);
+}
+
+std::size_t sfttf::Font::getCacheBudget() const
+{
+	FontManager::UseLock Lock(*myManager);
+	return myFontFace->getCacheBudget();
+}
+
+/*
+	Glyph records plus their area in the atlas.
+*/
+std::size_t sfttf::Font::getCacheSize() const
+{
+	FontManager::UseLock Lock(*myManager);
+	return myFontFace->getCacheSize();
+}
+
+std::size_t sfttf::Font::getTextureMemory() const
+{
+	FontManager::UseLock Lock(*myManager);
+	return myFontFace->myAtlas.getMemory();
+}
+
+bool sfttf::Font::pinChar(uint32_t codePoint)
+{
+	FontManager::UseLock Lock(*myManager);
+	myFontFace->beginUse();
+	return cachePhases(codePoint, true);
+}
+
+bool sfttf::Font::pinString(const std::string& s)
+{
+	return pinString(s.begin(), s.end());
+}
+
+bool sfttf::Font::pinString(const std::wstring& s)
+{
+	return pinString(s.begin(), s.end());
+}
+
+void sfttf::Font::unpinAll()
+{
+	FontManager::UseLock Lock(*myManager);
+	myFontFace->unpinAll();
+}
+
+bool sfttf::Font::saveCache(const std::string& Filename)
+{
+	FontManager::UseLock Lock(*myManager);
+	return myFontFace->saveCache(Filename);
+}
+
+bool sfttf::Font::loadCache(const std::string& Filename)
+{
+	FontManager::UseLock Lock(*myManager);
+	return myFontFace->loadCache(Filename);
+}
+
+/*
+	If Fill is true, the filled glyph will be cached/drawn.
+*/
+void sfttf::Font::setFill(bool Fill)
+{
+	mySettings.Fill = Fill;
+}
+
+/*
+	If Outline is true, the glyph outline will be cached/drawn
+*/
+void sfttf::Font::setOutline(bool Outline)
+{
+	mySettings.Outline = Outline;
+}
+
+/*
+When setSize is called, mySize is simply changed.
+
+FT_Set_Pixel_Sizes is only called when a glyph is rendered at
+another size than the last one (see Rasterizer::setSize).
+*/
+void sfttf::Font::setSize(int Size)
+{
+	mySettings.Size = std::abs(Size);
+}
+
+void sfttf::Font::setOutlineSize(int Size)
+{
+	mySettings.outlineSize = std::abs(Size);
+}
+
+void sfttf::Font::setColor(const sf::Color& Color)
+{
+	mySettings.Color = Color;
+}
+
+void sfttf::Font::setOutlineColor(const sf::Color& Color)
+{
+	mySettings.outlineColor = Color;
+}
+
+void sfttf::Font::setKerning(bool Kerning)
+{
+	mySettings.Kerning = Kerning;
+}
+
+void sfttf::Font::setCombine(bool Combine)
+{
+	mySettings.Combine = Combine;
+}
+
+void sfttf::Font::setDistanceField(bool DistanceField)
+{
+	mySettings.DistanceField = DistanceField;
+}
+
+void sfttf::Font::setSubpixel(bool Subpixel)
+{
+	mySettings.Subpixel = Subpixel;
+}
+
+void sfttf::Font::setAsync(bool Async)
+{
+	mySettings.Async = Async;
+}
+
+void sfttf::Font::setPlaceholder(uint32_t codePoint)
+{
+	mySettings.Placeholder = codePoint;
+}
+
+bool sfttf::Font::drawChar(uint32_t codePoint, float X, float Y)
+{
+	FontManager::UseLock Lock(*myManager);
+	sfttf::Glyph* filledGlyph = 0;
+	sfttf::Glyph* outlinedGlyph = 0;
+	float wholeX = X;
+	myFontFace->beginUse();
+	myBatch.Clear();
+	if (cacheChar(codePoint, filledGlyph, outlinedGlyph, getPhase(X, wholeX), mySettings.Async))
+	{
+		if (filledGlyph)
+		{
+			const float Scale = getScale(filledGlyph);
+			batchGlyph(myBatch, filledGlyph, wholeX + filledGlyph->bitmapLeft * Scale, Y - filledGlyph->bitmapTop * Scale, mySettings.Color);
+		}
+		if (outlinedGlyph)
+			batchGlyph(myBatch, outlinedGlyph, wholeX + static_cast<float>(outlinedGlyph->bitmapLeft), Y - static_cast<float>(outlinedGlyph->bitmapTop), mySettings.outlineColor);
+	}
+	if (!myBatch.isEmpty())
+		myWindow->Draw(myBatch);
+
+	return filledGlyph || outlinedGlyph;
+}
+
+bool sfttf::Font::drawString(const std::string& s, float X, float Y)
+{
+	return drawString(s.begin(), s.end(), X, Y);
+}
+
+bool sfttf::Font::drawString(const std::wstring& s, float X, float Y)
+{
+	return drawString(s.begin(), s.end(), X, Y);
+}
+
+bool sfttf::Font::drawCachedString(const std::string& s, float X, float Y)
+{
+	return drawCachedString(s.begin(), s.end(), X, Y);
+}
+
+bool sfttf::Font::drawCachedString(const std::wstring& s, float X, float Y)
+{
+	return drawCachedString(s.begin(), s.end(), X, Y);
+}
+
+void sfttf::Font::setStringCacheBudget(std::size_t Bytes)
+{
+	myStringImages.setBudget(Bytes);
+}
+
+std::size_t sfttf::Font::getStringCacheBudget() const
+{
+	return myStringImages.getBudget();
+}
+
+std::size_t sfttf::Font::getStringCacheSize() const
+{
+	return myStringImages.getSize();
+}
+
+unsigned int sfttf::Font::getCharWidth(uint32_t codePoint)
+{
+	FontManager::UseLock Lock(*myManager);
+	myFontFace->beginUse();
+	Glyph* g = measureChar(codePoint);
+	return g ? static_cast<unsigned int>(std::ceil(g->glyphWidth * getScale(g))) : 0;
+}
+
+unsigned int sfttf::Font::getCharHeight(uint32_t codePoint)
+{
+	FontManager::UseLock Lock(*myManager);
+	myFontFace->beginUse();
+	Glyph* g = measureChar(codePoint);
+	return g ? static_cast<unsigned int>(std::ceil(g->glyphHeight * getScale(g))) : 0;
+}
+
+unsigned int sfttf::Font::getStringWidth(const std::string& s)
+{
+	return getStringWidth(s.begin(), s.end());
+}
+
+unsigned int sfttf::Font::getStringWidth(const std::wstring& s)
+{
+	return getStringWidth(s.begin(), s.end());
+}
+
+unsigned int sfttf::Font::getStringHeight(const std::string& s)
+{
+	return getStringHeight(s.begin(), s.end());
+}
+
+unsigned int sfttf::Font::getStringHeight(const std::wstring& s)
+{
+	return getStringHeight(s.begin(), s.end());
+}
+
+sfttf::Font::StringBounds sfttf::Font::getStringBounds(const std::string& s)
+{
+	return getStringBounds(s.begin(), s.end());
+}
+
+sfttf::Font::StringBounds sfttf::Font::getStringBounds(const std::wstring& s)
+{
+	return getStringBounds(s.begin(), s.end());
+}
+
+bool sfttf::Font::getFill() const
+{
+	return mySettings.Fill;
+}
+
+bool sfttf::Font::getOutline() const
+{
+	return mySettings.Outline;
+}
+
+int sfttf::Font::getSize() const
+{
+	return mySettings.Size;
+}
+
+int sfttf::Font::getOutlineSize() const
+{
+	return mySettings.outlineSize;
+}
+
+bool sfttf::Font::getKerning() const
+{
+	return mySettings.Kerning;
+}
+
+bool sfttf::Font::getCombine() const
+{
+	return mySettings.Combine;
+}
+
+bool sfttf::Font::getDistanceField() const
+{
+	return mySettings.DistanceField;
+}
+
+bool sfttf::Font::getSubpixel() const
+{
+	return mySettings.Subpixel;
+}
+
+bool sfttf::Font::getAsync() const
+{
+	return mySettings.Async;
+}
+
+sfttf::uint32_t sfttf::Font::getPlaceholder() const
+{
+	return mySettings.Placeholder;
+}
+
+void sfttf::Font::Push()
+{
+	mySettingsStack.push_back(mySettings);
+}
+
+void sfttf::Font::Pop()
+{
+	if (mySettingsStack.empty())
+		return;
+
+	mySettings = mySettingsStack.back();
+	mySettingsStack.pop_back();
+}
+
+sfttf::Font::Font(FontManager* Manager, sf::RenderWindow* Window, FontFace* Face) : myManager(Manager),
+																					myWindow(Window),
+																					myFontFace(Face),
+																					myBatch(Face->myAtlas),
+																					myUsedPlaceholder(false)
+{
+}
+
+sfttf::Font::~Font()
+{
+}
+
+/*
+	Glyphs for measuring, subpixel glyphs are measured at their first phase.
+	Measuring never uses placeholders.
+*/
+bool sfttf::Font::cacheChar(uint32_t codePoint, Glyph*& filledGlyph, Glyph*& outlinedGlyph)
+{
+	return cacheChar(codePoint, filledGlyph, outlinedGlyph, useSubpixel() ? 1 : 0, false);
+}
+
+/*
+	Looks up and, if needed, caches the glyphs for the current settings.
+	Glyphs that are not enabled are set to 0.
+	A combined glyph is returned as outlinedGlyph, with no filledGlyph.
+	A distance field glyph is returned as filledGlyph, it draws the outline too.
+	Phase is ignored for distance field glyphs.
+	With Async, glyphs being rendered by the workers are replaced by
+	the placeholder's (see setAsync).
+*/
+bool sfttf::Font::cacheChar(uint32_t codePoint, Glyph*& filledGlyph, Glyph*& outlinedGlyph, int Phase, bool Async)
+{
+	filledGlyph = 0;
+	outlinedGlyph = 0;
+	GlyphKey Keys[2];
+	int keyCount = 0;
+	if (!getGlyphKeys(codePoint, Phase, Keys, keyCount))
+		return false;
+
+	bool Result = true;
+	bool anyPending = false;
+	for (int i = 0; i < keyCount; ++i)
+	{
+		bool Pending = false;
+		Glyph* cachedGlyph = myFontFace->cacheGlyph(Keys[i], Async, Pending);
+		if (0 == Keys[i].outlineSize)
+			filledGlyph = cachedGlyph;
+		else
+			outlinedGlyph = cachedGlyph;
+
+		if (Pending)
+			anyPending = true;
+		else if (0 == cachedGlyph)
+			Result = false;
+	}
+	if (!anyPending)
+		return Result;
+
+	myUsedPlaceholder = true;
+	if (0 == mySettings.Placeholder || codePoint == mySettings.Placeholder)
+	{
+		filledGlyph = 0;
+		outlinedGlyph = 0;
+		return true;
+	}
+	return cacheChar(mySettings.Placeholder, filledGlyph, outlinedGlyph, Phase, false);
+}
+
+/*
+	cacheChar for measuring without the lock (see Reclaimer): only finds
+	glyphs that are already cached or measured (see FontFace::getMetrics),
+	and does not mark them as used.
+	Returns false if one is missing.
+*/
+bool sfttf::Font::findChar(uint32_t codePoint, Glyph*& filledGlyph, Glyph*& outlinedGlyph) const
+{
+	filledGlyph = 0;
+	outlinedGlyph = 0;
+	GlyphKey Keys[2];
+	int keyCount = 0;
+	if (!getGlyphKeys(codePoint, useSubpixel() ? 1 : 0, Keys, keyCount))
+		return false;
+
+	for (int i = 0; i < keyCount; ++i)
+	{
+		Glyph* cachedGlyph = myFontFace->myGlyphs.Find(Keys[i]);
+		if (0 == cachedGlyph)
+			cachedGlyph = myFontFace->myMeasured.Find(Keys[i]);
+
+		if (0 == cachedGlyph)
+			return false;
+
+		if (0 == Keys[i].outlineSize)
+			filledGlyph = cachedGlyph;
+		else
+			outlinedGlyph = cachedGlyph;
+	}
+	return true;
+}
+
+/*
+	The glyph a character is measured with for the current settings,
+	from its metrics (see FontFace::getMetrics) so nothing is rendered.
+	The outline is preferred as it should be larger.
+	Returns 0 if a glyph cannot be loaded or none is enabled.
+*/
+sfttf::Glyph* sfttf::Font::measureChar(uint32_t codePoint)
+{
+	GlyphKey Keys[2];
+	int keyCount = 0;
+	if (!getGlyphKeys(codePoint, useSubpixel() ? 1 : 0, Keys, keyCount))
+		return 0;
+
+	Glyph* g = 0;
+	for (int i = 0; i < keyCount; ++i)
+	{
+		Glyph* Metrics = myFontFace->getMetrics(Keys[i]);
+		if (!Metrics)
+			return 0;
+
+		if (!g || 0 != Keys[i].outlineSize)
+			g = Metrics;
+	}
+	return g;
+}
+
+/*
+	The keys of the glyphs cacheChar looks up for the current settings,
+	see cacheChar. Distance field and filled glyphs have an outlineSize of 0.
+	Returns false if there is no size to render glyphs at.
+*/
+bool sfttf::Font::getGlyphKeys(uint32_t codePoint, int Phase, GlyphKey* Keys, int& keyCount) const
+{
+	keyCount = 0;
+	if (useDistanceField())
+	{
+		if (mySettings.Fill || (mySettings.Outline && 0 != mySettings.outlineSize))
+			Keys[keyCount++] = GlyphKey(codePoint, 0, 0, false, 0);
+	}
+	else if (0 == mySettings.Size)
+		return false;
+	else if (useCombined())
+		Keys[keyCount++] = GlyphKey(codePoint, mySettings.Size, mySettings.outlineSize, true, Phase);
+	else
+	{
+		if (mySettings.Fill)
+			Keys[keyCount++] = GlyphKey(codePoint, mySettings.Size, 0, false, Phase);
+
+		if (mySettings.Outline && 0 != mySettings.outlineSize)
+			Keys[keyCount++] = GlyphKey(codePoint, mySettings.Size, mySettings.outlineSize, false, Phase);
+	}
+	return true;
+}
+
+/*
+	Adds the keys of every glyph cachePhases caches for codePoint.
+*/
+bool sfttf::Font::addPhaseKeys(uint32_t codePoint, std::vector<GlyphKey>& Keys) const
+{
+	const int firstPhase = useSubpixel() ? 1 : 0;
+	const int lastPhase = useSubpixel() ? FontFace::subpixelPhases : 0;
+	for (int Phase = firstPhase; Phase <= lastPhase; ++Phase)
+	{
+		GlyphKey phaseKeys[2];
+		int keyCount = 0;
+		if (!getGlyphKeys(codePoint, Phase, phaseKeys, keyCount))
+			return false;
+
+		Keys.insert(Keys.end(), phaseKeys, phaseKeys + keyCount);
+	}
+	return true;
+}
+
+/*
+	Caches (and pins if Pin is true) every glyph drawString may need
+	for a character: all its phases in subpixel mode.
+*/
+bool sfttf::Font::cachePhases(uint32_t codePoint, bool Pin)
+{
+	bool Result = true;
+	const int firstPhase = useSubpixel() ? 1 : 0;
+	const int lastPhase = useSubpixel() ? FontFace::subpixelPhases : 0;
+	for (int Phase = firstPhase; Phase <= lastPhase; ++Phase)
+	{
+		Glyph* filledGlyph = 0;
+		Glyph* outlinedGlyph = 0;
+		if (!cacheChar(codePoint, filledGlyph, outlinedGlyph, Phase, mySettings.Async && !Pin))
+			Result = false;
+
+		if (Pin)
+		{
+			myFontFace->pinGlyph(filledGlyph);
+			myFontFace->pinGlyph(outlinedGlyph);
+		}
+	}
+	return Result;
+}
+
+/*
+	Combined glyphs blend both colors from the texture, which only gives
+	the same result as separate glyphs when the alphas are equal.
+*/
+bool sfttf::Font::useCombined() const
+{
+	return mySettings.Combine &&
+		mySettings.Fill &&
+		mySettings.Outline &&
+		0 != mySettings.outlineSize &&
+		mySettings.Color.a == mySettings.outlineColor.a &&
+		GlyphBatch::isCombineSupported();
+}
+
+bool sfttf::Font::useDistanceField() const
+{
+	return mySettings.DistanceField && 0 != DistanceFieldProgram::getProgram();
+}
+
+bool sfttf::Font::useSubpixel() const
+{
+	return mySettings.Subpixel && !useDistanceField();
+}
+
+/*
+	The phase of the glyphs to draw at X, and the whole pixel to draw them at.
+	X is rounded to the nearest phase, the last one rounding up
+	to phase 1 of the next pixel.
+*/
+int sfttf::Font::getPhase(float X, float& wholeX) const
+{
+	if (!useSubpixel())
+	{
+		wholeX = X;
+		return 0;
+	}
+	const float Phases = static_cast<float>(FontFace::subpixelPhases);
+	const float Steps = std::floor(X * Phases + 0.5f);
+	wholeX = std::floor(Steps / Phases);
+	return 1 + static_cast<int>(Steps - wholeX * Phases);
+}
+
+/*
+	Distance field glyphs are scaled from the size they were rendered at.
+*/
+float sfttf::Font::getScale(const Glyph* g) const
+{
+	if (0 != g->Size)
+		return 1.0f;
+
+	return static_cast<float>(mySettings.Size) / static_cast<float>(FontFace::distanceFieldSize);
+}
+
+/*
+	Subpixel and distance field glyphs advance by fractions of a pixel.
+*/
+float sfttf::Font::getAdvance(const Glyph* g) const
+{
+	if (0 == g->Size || 0 != g->Phase)
+		return g->xAdvanceFixed * getScale(g) / 64.0f;
+
+	return static_cast<float>(g->xAdvance);
+}
+
+/*
+	Glyphs are only added to a batch here, drawString/drawChar draw the batch
+	once everything has been added.
+*/
+void sfttf::Font::batchGlyph(GlyphBatch& Batch, Glyph* g, float X, float Y, const sf::Color& Color)
+{
+	if (0 == g->glyphWidth || 0 == g->glyphHeight)
+		return;
+
+	if (0 == g->Size)
+	{
+		/*
+			The outline width goes from pixels at this size to field units
+			(127 per distanceFieldSpread pixels at distanceFieldSize).
+		*/
+		const sf::Color Transparent(0, 0, 0, 0);
+		const bool drawOutline = mySettings.Outline && 0 != mySettings.outlineSize;
+		const float Scale = getScale(g);
+		const float outlineWidth = static_cast<float>(mySettings.outlineSize) / Scale * 127.0f / (255.0f * FontFace::distanceFieldSpread);
+		Batch.Add(*g,
+			X,
+			Y,
+			Scale,
+			mySettings.Fill ? mySettings.Color : Transparent,
+			drawOutline ? mySettings.outlineColor : Transparent,
+			drawOutline ? outlineWidth : 0.0f);
+	}
+	else if (g->Combined)
+		Batch.Add(*g, X, Y, mySettings.Color, mySettings.outlineColor);
+	else
+		Batch.Add(*g, X, Y, Color);
+}
+
+sfttf::Glyph* sfttf::Font::batchChar(GlyphBatch& Batch, uint32_t codePoint, float& penX, float& penY, Glyph* previousGlyph)
+{
+	PlacedChar Placed;
+	if (!placeChar(codePoint, penX, penY, previousGlyph, Placed))
+		return 0;
+
+	batchPlaced(Batch, Placed);
+	return Placed.outlinedGlyph ? Placed.outlinedGlyph : Placed.filledGlyph;
+}
+
+/*
+	Caches a character's glyphs, applies kerning and moves the pen past it.
+	On failure the pen is left where it was and the glyphs are 0.
+*/
+bool sfttf::Font::placeChar(uint32_t codePoint, float& penX, float& penY, Glyph* previousGlyph, PlacedChar& Placed)
+{
+	Placed.penX = penX;
+	Placed.penY = penY;
+	Placed.filledGlyph = 0;
+	Placed.outlinedGlyph = 0;
+
+	sfttf::Glyph* filledGlyph = 0;
+	sfttf::Glyph* outlinedGlyph = 0;
+	float wholeX = penX;
+	const int Phase = getPhase(penX, wholeX);
+	if (!cacheChar(codePoint, filledGlyph, outlinedGlyph, Phase, mySettings.Async))
+		return false;
+
+	float kerningX = 0.0f;
+	float kerningY = 0.0f;
+	if (filledGlyph)
+		getKerning(previousGlyph, filledGlyph, &kerningX, &kerningY);
+	else if (outlinedGlyph)
+		getKerning(previousGlyph, outlinedGlyph, &kerningX, &kerningY);
+
+	float kernedX = penX + kerningX;
+	const float kernedY = penY + kerningY;
+	/*
+		Kerning can move the pen to another phase.
+	*/
+	if (0.0f != kerningX)
+	{
+		const int kernedPhase = getPhase(kernedX, wholeX);
+		if (kernedPhase != Phase && !cacheChar(codePoint, filledGlyph, outlinedGlyph, kernedPhase, mySettings.Async))
+			return false;
+	}
+
+	Placed.filledGlyph = filledGlyph;
+	Placed.outlinedGlyph = outlinedGlyph;
+	Placed.X = wholeX;
+	Placed.Y = kernedY;
+	if (outlinedGlyph)
+		kernedX += getAdvance(outlinedGlyph);
+	else if (filledGlyph)
+		kernedX += getAdvance(filledGlyph);
+
+	penX = kernedX;
+	penY = kernedY;
+	Placed.nextX = penX;
+	Placed.nextY = penY;
+	return true;
+}
+
+void sfttf::Font::batchPlaced(GlyphBatch& Batch, const PlacedChar& Placed)
+{
+	if (Placed.filledGlyph)
+	{
+		const float Scale = getScale(Placed.filledGlyph);
+		batchGlyph(Batch, Placed.filledGlyph, Placed.X + Placed.filledGlyph->bitmapLeft * Scale, Placed.Y - Placed.filledGlyph->bitmapTop * Scale, mySettings.Color);
+	}
+	if (Placed.outlinedGlyph)
+		batchGlyph(Batch, Placed.outlinedGlyph, Placed.X + static_cast<float>(Placed.outlinedGlyph->bitmapLeft), Placed.Y - static_cast<float>(Placed.outlinedGlyph->bitmapTop), mySettings.outlineColor);
+}
+
+/*
+	This gets the relative offsets for kerning, in pixels.
+	They are only fractional in subpixel mode.
+*/
+void sfttf::Font::getKerning(Glyph* leftGlyph, Glyph* rightGlyph, float* offsetX, float* offsetY)
+{
+	int X = 0;
+	int Y = 0;
+	if (mySettings.Kerning)
+		myFontFace->getKerning(leftGlyph, rightGlyph, mySettings.Size, useSubpixel(), &X, &Y);
+
+	if (useSubpixel())
+	{
+		if (offsetX)
+			*offsetX = X / 64.0f;
+
+		if (offsetY)
+			*offsetY = Y / 64.0f;
+	}
+	else
+	{
+		if (offsetX)
+			*offsetX = static_cast<float>(X >> 6);
+
+		if (offsetY)
+			*offsetY = static_cast<float>(Y >> 6);
+	}
+}
+
+/*
+	getKerning for measuring without the lock, see FontFace::findKerning.
+*/
+bool sfttf::Font::findKerning(const Glyph* leftGlyph, const Glyph* rightGlyph, float* offsetX) const
+{
+	int X = 0;
+	if (mySettings.Kerning && !myFontFace->findKerning(leftGlyph, rightGlyph, mySettings.Size, useSubpixel(), &X, 0))
+		return false;
+
+	*offsetX = useSubpixel() ? X / 64.0f : static_cast<float>(X >> 6);
+	return true;
+}
+
+/*
+	Lays Text out into Batch with runSettings, the pen starting at 0, 0.
+	The glyphs placed are added to Glyphs if it is not 0.
+*/
+void sfttf::Font::layoutRun(const Settings& runSettings, const std::vector<uint32_t>& Text, GlyphBatch& Batch, std::vector<Glyph*>* Glyphs)
+{
+	float penX = 0.0f;
+	float penY = 0.0f;
+	Glyph* previousGlyph = 0;
+	Push();
+	mySettings = runSettings;
+	myFontFace->beginUse();
+	Batch.Clear();
+	std::vector<uint32_t>::const_iterator itCodePoint(Text.begin());
+	const std::vector<uint32_t>::const_iterator itEnd(Text.end());
+	for (; itEnd != itCodePoint; ++itCodePoint)
+	{
+		PlacedChar Placed;
+		if (!placeChar(*itCodePoint, penX, penY, previousGlyph, Placed))
+		{
+			previousGlyph = 0;
+			continue;
+		}
+		batchPlaced(Batch, Placed);
+		if (Glyphs && Placed.filledGlyph)
+			Glyphs->push_back(Placed.filledGlyph);
+
+		if (Glyphs && Placed.outlinedGlyph)
+			Glyphs->push_back(Placed.outlinedGlyph);
+
+		previousGlyph = Placed.outlinedGlyph ? Placed.outlinedGlyph : Placed.filledGlyph;
+	}
+	Pop();
+}
+
+/*
+	Lays Text out like layoutRun, Layout holding the placement of oldText.
+	Characters that are the same as in oldText, with the pen and the previous
+	glyph in the same place, keep their placement. Others are placed again.
+	Layout must be empty if glyphs were removed since it was made.
+*/
+void sfttf::Font::updateRun(const Settings& runSettings, const std::vector<uint32_t>& oldText, const std::vector<uint32_t>& Text, PlacedCharList& Layout, GlyphBatch& Batch)
+{
+	float penX = 0.0f;
+	float penY = 0.0f;
+	Glyph* previousGlyph = 0;
+	Glyph* oldPreviousGlyph = 0;
+	const std::size_t oldSize = std::min(oldText.size(), Layout.size());
+	Push();
+	mySettings = runSettings;
+	myFontFace->beginUse();
+	Batch.Clear();
+	Layout.resize(Text.size());
+	for (std::size_t i = 0; i < Text.size(); ++i)
+	{
+		PlacedChar& Placed = Layout[i];
+		Glyph* oldGlyph = 0;
+		bool Reuse = false;
+		if (i < oldSize)
+		{
+			oldGlyph = Placed.outlinedGlyph ? Placed.outlinedGlyph : Placed.filledGlyph;
+			Reuse = Text[i] == oldText[i] &&
+				Placed.penX == penX &&
+				Placed.penY == penY &&
+				oldPreviousGlyph == previousGlyph;
+		}
+		oldPreviousGlyph = oldGlyph;
+
+		if (Reuse)
+		{
+			/*
+				Touched so they are not evicted while placing the others.
+			*/
+			if (Placed.filledGlyph)
+				myFontFace->touchGlyph(Placed.filledGlyph);
+
+			if (Placed.outlinedGlyph)
+				myFontFace->touchGlyph(Placed.outlinedGlyph);
+
+			penX = Placed.nextX;
+			penY = Placed.nextY;
+		}
+		else if (!placeChar(Text[i], penX, penY, previousGlyph, Placed))
+		{
+			Placed.nextX = penX;
+			Placed.nextY = penY;
+		}
+		previousGlyph = Placed.outlinedGlyph ? Placed.outlinedGlyph : Placed.filledGlyph;
+	}
+	PlacedCharList::const_iterator itPlaced(Layout.begin());
+	const PlacedCharList::const_iterator itEnd(Layout.end());
+	for (; itEnd != itPlaced; ++itPlaced)
+		batchPlaced(Batch, *itPlaced);
+
+	Pop();
+}
+
+/*
+	Breaks Text into Lines at most Width pixels wide (no limit if Width
+	is 0), from the start of Lines[firstLine] on. The lines before it
+	are kept, firstLine must be 0 if Lines is empty.
+	Characters are measured from their metrics, nothing is rendered.
+*/
+void sfttf::Font::breakLines(const Settings& runSettings, const std::vector<uint32_t>& Text, float Width, std::size_t firstLine, LineList& Lines)
+{
+	std::size_t Start = (firstLine < Lines.size()) ? Lines[firstLine].Start : 0;
+	Lines.resize(firstLine);
+	if (Text.empty())
+		return;
+
+	Push();
+	mySettings = runSettings;
+	myFontFace->beginUse();
+	bool newLine = true;
+	while (Start < Text.size() || newLine)
+	{
+		Line nextLine;
+		nextLine.Start = Start;
+		newLine = breakLine(Text, Width, nextLine);
+		Lines.push_back(nextLine);
+		Start = nextLine.Next;
+	}
+	Pop();
+}
+
+/*
+	Fills theLine from theLine.Start, in one pass.
+	Lines are broken at the last run of spaces before the first glyph
+	that does not fit, or before that glyph if it is in the line's first
+	word. A line always takes at least one glyph, even if it is too wide.
+	Returns true if the line ends with a new line character.
+*/
+bool sfttf::Font::breakLine(const std::vector<uint32_t>& Text, float Width, Line& theLine)
+{
+	const std::size_t noBreak = static_cast<std::size_t>(-1);
+	const std::size_t Start = theLine.Start;
+	float penX = 0.0f;
+	Glyph* previousGlyph = 0;
+	std::size_t inkEnd = Start;
+	float inkWidth = 0.0f;
+	std::size_t breakEnd = noBreak;
+	std::size_t breakNext = noBreak;
+	float breakWidth = 0.0f;
+	bool inSpaces = false;
+	for (std::size_t i = Start; i < Text.size(); ++i)
+	{
+		const uint32_t codePoint = Text[i];
+		if ('\n' == codePoint)
+		{
+			theLine.Length = inkEnd - Start;
+			theLine.Width = inkWidth;
+			theLine.Next = i + 1;
+			return true;
+		}
+
+		Glyph* g = measureChar(codePoint);
+		if (!g)
+			continue;
+
+		float kerningX = 0.0f;
+		getKerning(previousGlyph, g, &kerningX, 0);
+		const float charX = penX + kerningX;
+		if (' ' == codePoint || '\t' == codePoint)
+		{
+			if (!inSpaces && inkEnd != Start)
+			{
+				breakEnd = inkEnd;
+				breakWidth = inkWidth;
+				breakNext = noBreak;
+			}
+			inSpaces = true;
+		}
+		else
+		{
+			if (inSpaces && noBreak != breakEnd)
+				breakNext = i;
+
+			inSpaces = false;
+			const float Right = charX + g->glyphWidth * getScale(g);
+			if (0.0f < Width && Width < Right && inkEnd != Start)
+			{
+				if (noBreak != breakNext)
+				{
+					theLine.Length = breakEnd - Start;
+					theLine.Width = breakWidth;
+					theLine.Next = breakNext;
+				}
+				else
+				{
+					theLine.Length = inkEnd - Start;
+					theLine.Width = inkWidth;
+					theLine.Next = i;
+				}
+				return false;
+			}
+			inkEnd = i + 1;
+			inkWidth = Right;
+		}
+		penX = charX + getAdvance(g);
+		previousGlyph = g;
+	}
+	theLine.Length = inkEnd - Start;
+	theLine.Width = inkWidth;
+	theLine.Next = Text.size();
+	return false;
+}
+
+/*
+	Places the characters of Lines from firstLine on, into Layout, and
+	refills Batch. The placement of the lines before firstLine is kept,
+	like updateRun Layout must be empty if glyphs were removed since.
+	Each line is moved right by Align (0 to 1) of the space boxWidth
+	leaves, the first baseline is at the font's ascender.
+*/
+void sfttf::Font::layoutLines(const Settings& runSettings, const std::vector<uint32_t>& Text, const LineList& Lines, std::size_t firstLine, float boxWidth, float Align, float lineSpacing, PlacedCharList& Layout, GlyphBatch& Batch)
+{
+	float Ascender = 0.0f;
+	float lineAdvance = 0.0f;
+	getLineMetrics(runSettings, lineSpacing, Ascender, lineAdvance);
+
+	Push();
+	mySettings = runSettings;
+	myFontFace->beginUse();
+	Batch.Clear();
+	Layout.resize(Text.size());
+	const std::size_t firstPlaced = (firstLine < Lines.size()) ? Lines[firstLine].Start : Text.size();
+	for (std::size_t i = 0; i < firstPlaced; ++i)
+	{
+		/*
+			Touched so they are not evicted while placing the others.
+		*/
+		if (Layout[i].filledGlyph)
+			myFontFace->touchGlyph(Layout[i].filledGlyph);
+
+		if (Layout[i].outlinedGlyph)
+			myFontFace->touchGlyph(Layout[i].outlinedGlyph);
+	}
+
+	for (std::size_t l = firstLine; l < Lines.size(); ++l)
+	{
+		const Line& theLine = Lines[l];
+		float penX = std::max(0.0f, (boxWidth - theLine.Width) * Align);
+		if (!useSubpixel())
+			penX = std::floor(penX);
+
+		float penY = Ascender + static_cast<float>(l) * lineAdvance;
+		Glyph* previousGlyph = 0;
+		for (std::size_t i = theLine.Start; i < theLine.Next; ++i)
+		{
+			PlacedChar& Placed = Layout[i];
+			if (i >= theLine.Start + theLine.Length || !placeChar(Text[i], penX, penY, previousGlyph, Placed))
+			{
+				Placed.penX = penX;
+				Placed.penY = penY;
+				Placed.filledGlyph = 0;
+				Placed.outlinedGlyph = 0;
+				Placed.X = penX;
+				Placed.Y = penY;
+				Placed.nextX = penX;
+				Placed.nextY = penY;
+			}
+			previousGlyph = Placed.outlinedGlyph ? Placed.outlinedGlyph : Placed.filledGlyph;
+		}
+	}
+	PlacedCharList::const_iterator itPlaced(Layout.begin());
+	const PlacedCharList::const_iterator itEnd(Layout.end());
+	for (; itEnd != itPlaced; ++itPlaced)
+		batchPlaced(Batch, *itPlaced);
+
+	Pop();
+}
+
+/*
+	Baselines are lineAdvance apart, both are whole pixels.
+*/
+void sfttf::Font::getLineMetrics(const Settings& runSettings, float lineSpacing, float& Ascender, float& lineAdvance)
+{
+	int fontAscender = 0;
+	int lineHeight = 0;
+	myFontFace->getLineMetrics(runSettings.Size, fontAscender, lineHeight);
+	Ascender = static_cast<float>(fontAscender);
+	lineAdvance = std::floor(static_cast<float>(lineHeight) * lineSpacing + 0.5f);
+}
+
+sfttf::Font::LayoutGlyphs::LayoutGlyphs(Font& theFont) : myFont(&theFont),
+														 myClearCount(0),
+														 myArrivalCount(0),
+														 myCurrent(false),
+														 myIncomplete(false)
+{
+}
+
+sfttf::Font::LayoutGlyphs::LayoutGlyphs(const LayoutGlyphs& Other) : myFont(Other.myFont),
+																	 myClearCount(0),
+																	 myArrivalCount(0),
+																	 myCurrent(false),
+																	 myIncomplete(false)
+{
+}
+
+sfttf::Font::LayoutGlyphs::~LayoutGlyphs()
+{
+	UseLock Lock(*myFont->myManager);
+	Release();
+}
+
+sfttf::Font::LayoutGlyphs& sfttf::Font::LayoutGlyphs::operator=(const LayoutGlyphs& Other)
+{
+	if (this != &Other)
+	{
+		{
+			UseLock Lock(*myFont->myManager);
+			Release();
+		}
+		myFont = Other.myFont;
+		myCurrent = false;
+		myIncomplete = false;
+	}
+	return *this;
+}
+
+/*
+	Arrivals are counted from before the layout: glyphs that arrive
+	while it is made may have been placeholders in it.
+*/
+void sfttf::Font::LayoutGlyphs::beginLayout()
+{
+	myFont->myUsedPlaceholder = false;
+	myArrivalCount = myFont->myFontFace->myArrivalCount;
+}
+
+/*
+	The new glyphs are held before the previous ones are released,
+	so the glyphs both layouts use stay out of the LRU list.
+*/
+void sfttf::Font::LayoutGlyphs::endLayout(const std::vector<Glyph*>& Glyphs, bool Kept)
+{
+	FontFace* Face = myFont->myFontFace;
+	std::vector<Glyph*>::const_iterator itGlyph(Glyphs.begin());
+	const std::vector<Glyph*>::const_iterator itEnd(Glyphs.end());
+	for (; itEnd != itGlyph; ++itGlyph)
+		Face->holdGlyph(*itGlyph);
+
+	Release();
+	myHeld = Glyphs;
+	myClearCount = Face->myClearCount;
+	myIncomplete = myFont->myUsedPlaceholder || (Kept && myIncomplete);
+	myCurrent = true;
+}
+
+void sfttf::Font::LayoutGlyphs::endLayout(const PlacedCharList& Layout, bool Kept)
+{
+	std::vector<Glyph*> Glyphs;
+	PlacedCharList::const_iterator itPlaced(Layout.begin());
+	const PlacedCharList::const_iterator itEnd(Layout.end());
+	for (; itEnd != itPlaced; ++itPlaced)
+	{
+		if (itPlaced->filledGlyph)
+			Glyphs.push_back(itPlaced->filledGlyph);
+
+		if (itPlaced->outlinedGlyph)
+			Glyphs.push_back(itPlaced->outlinedGlyph);
+	}
+	endLayout(Glyphs, Kept);
+}
+
+/*
+	Glyphs the workers finished are added first, so layouts made with
+	placeholders see that they must be made again.
+*/
+bool sfttf::Font::LayoutGlyphs::isCurrent() const
+{
+	FontFace* Face = myFont->myFontFace;
+	Face->collectGlyphs();
+	return myCurrent &&
+		myClearCount == Face->myClearCount &&
+		(!myIncomplete || myArrivalCount == Face->myArrivalCount);
+}
+
+/*
+	Glyphs removed by clearCache are gone, only the others are released.
+*/
+void sfttf::Font::LayoutGlyphs::Release()
+{
+	FontFace* Face = myFont->myFontFace;
+	if (myClearCount == Face->myClearCount)
+	{
+		std::vector<Glyph*>::const_iterator itGlyph(myHeld.begin());
+		const std::vector<Glyph*>::const_iterator itEnd(myHeld.end());
+		for (; itEnd != itGlyph; ++itGlyph)
+			Face->releaseGlyph(*itGlyph);
+	}
+	myHeld.clear();
+	myCurrent = false;
+}
+
+sfttf::GlyphAtlas& sfttf::Font::getAtlas()
+{
+	return myFontFace->myAtlas;
+}
+
+template <typename TIterator>
+bool sfttf::Font::cacheString(TIterator itCodePoint, const TIterator& itEnd)
+{
+	FontManager::UseLock Lock(*myManager);
+	bool Result = true;
+	myFontFace->beginUse();
+	for (; itEnd != itCodePoint; ++itCodePoint)
+	{
+		if (!cachePhases(*itCodePoint, false))
+			Result = false;
+	}
+	return Result;
+}
+
+template <typename TIterator>
+bool sfttf::Font::pinString(TIterator itCodePoint, const TIterator& itEnd)
+{
+	FontManager::UseLock Lock(*myManager);
+	bool Result = true;
+	myFontFace->beginUse();
+	for (; itEnd != itCodePoint; ++itCodePoint)
+	{
+		if (!cachePhases(*itCodePoint, true))
+			Result = false;
+	}
+	return Result;
+}
+
+template <typename TIterator>
+bool sfttf::Font::drawString(TIterator itCodePoint, const TIterator& itEnd, float X, float Y)
+{
+	FontManager::UseLock Lock(*myManager);
+	float penX = X;
+	float penY = Y;
+	bool Result = true;
+	uint32_t codePoint = 0;
+	Glyph* g = 0;
+	Glyph* previousGlyph = 0;
+	myFontFace->beginUse();
+	myBatch.Clear();
+	for (; itEnd != itCodePoint; ++itCodePoint)
+	{
+		codePoint = *itCodePoint;
+		g = batchChar(myBatch, codePoint, penX, penY, previousGlyph);
+		if (0 == g)
+			Result = false;
+
+		previousGlyph = g;
+	}
+	if (!myBatch.isEmpty())
+		myWindow->Draw(myBatch);
+
+	return Result;
+}
+
+/*
+	Images too large for the budget are drawn once and thrown away
+	(see StringImageCache::Insert).
+*/
+template <typename TIterator>
+bool sfttf::Font::drawCachedString(TIterator itCodePoint, const TIterator& itEnd, float X, float Y)
+{
+	FontManager::UseLock Lock(*myManager);
+	StringImageKey Key;
+	for (; itEnd != itCodePoint; ++itCodePoint)
+		Key.Text.push_back(static_cast<uint32_t>(*itCodePoint));
+
+	Key.Fill = mySettings.Fill;
+	Key.Outline = mySettings.Outline;
+	Key.Size = mySettings.Size;
+	Key.outlineSize = mySettings.outlineSize;
+	Key.Kerning = mySettings.Kerning;
+	Key.Combine = useCombined();
+	Key.Subpixel = useSubpixel();
+	Key.Color = mySettings.Color;
+	Key.outlineColor = mySettings.outlineColor;
+
+	StringImage* Image = myStringImages.Find(Key);
+	const bool newImage = (0 == Image);
+	if (newImage)
+	{
+		if (!createStringImage(Key.Text, Image))
+			return false;
+
+		/*
+			Nothing to draw (e.g. only spaces).
+		*/
+		if (!Image)
+			return true;
+	}
+	/*
+		The image was laid out from X and Y at whole pixels (at phase 0
+		with subpixel glyphs), and is drawn 1:1 without filtering.
+	*/
+	Image->Sprite.SetPosition(std::floor(X + 0.5f) + static_cast<float>(Image->Left), std::floor(Y + 0.5f) + static_cast<float>(Image->Top));
+	myWindow->Draw(Image->Sprite);
+
+	if (newImage)
+		myStringImages.Insert(Key, Image);
+
+	return true;
+}
+
+/*
+	Lays Text out like drawString would, then composites the quads
+	into a new image instead of drawing them.
+	Image is set to 0 if there is nothing to draw.
+*/
+bool sfttf::Font::createStringImage(const std::vector<uint32_t>& Text, StringImage*& Image)
+{
+	Image = 0;
+	Settings imageSettings(mySettings);
+	imageSettings.Subpixel = useSubpixel();
+	imageSettings.DistanceField = false;
+	imageSettings.Async = false;
+	GlyphBatch Batch(getAtlas());
+	layoutRun(imageSettings, Text, Batch, 0);
+	if (Batch.isEmpty())
+		return true;
+
+	const sf::FloatRect& Bounds = Batch.getBounds();
+	const int Left = static_cast<int>(std::floor(Bounds.Left));
+	const int Top = static_cast<int>(std::floor(Bounds.Top));
+	const unsigned int Width = static_cast<unsigned int>(static_cast<int>(std::ceil(Bounds.Right)) - Left);
+	const unsigned int Height = static_cast<unsigned int>(static_cast<int>(std::ceil(Bounds.Bottom)) - Top);
+
+	std::vector<sf::Uint8> Pixels(Width * Height * 4, 0);
+	Batch.Composite(&Pixels[0], Width, Height, -Left, -Top);
+
+	StringImage* newImage = new StringImage;
+	newImage->Left = Left;
+	newImage->Top = Top;
+	if (!newImage->Image.LoadFromPixels(Width, Height, &Pixels[0]))
+	{
+		delete newImage;
+		return false;
+	}
+	/*
+		The image is always drawn at whole pixels, 1:1.
+	*/
+	newImage->Image.SetSmooth(false);
+	newImage->Sprite.SetImage(newImage->Image);
+	Image = newImage;
+	return true;
+}
+
+template <typename TIterator>
+unsigned int sfttf::Font::getStringWidth(TIterator itCodePoint, const TIterator& itEnd)
+{
+	float Width = 0.0f;
+	if (myManager->isThreadSafe())
+	{
+		Reclaimer::Reader Read(myFontFace->myReclaimer);
+		if (measureWidth(itCodePoint, itEnd, true, Width))
+			return static_cast<unsigned int>(std::ceil(Width));
+	}
+	FontManager::UseLock Lock(*myManager);
+	myFontFace->beginUse();
+	measureWidth(itCodePoint, itEnd, false, Width);
+	return static_cast<unsigned int>(std::ceil(Width));
+}
+
+template <typename TIterator>
+unsigned int sfttf::Font::getStringHeight(TIterator itCodePoint, const TIterator& itEnd)
+{
+	float Height = 0.0f;
+	if (myManager->isThreadSafe())
+	{
+		Reclaimer::Reader Read(myFontFace->myReclaimer);
+		if (measureHeight(itCodePoint, itEnd, true, Height))
+			return static_cast<unsigned int>(std::ceil(Height));
+	}
+	FontManager::UseLock Lock(*myManager);
+	myFontFace->beginUse();
+	measureHeight(itCodePoint, itEnd, false, Height);
+	return static_cast<unsigned int>(std::ceil(Height));
+}
+
+/*
+	With Cached, only glyphs already cached are used (findChar, which
+	needs no lock): false is returned as soon as one is missing, and
+	the string has to be measured again without Cached.
+*/
+template <typename TIterator>
+bool sfttf::Font::measureWidth(TIterator itCodePoint, const TIterator& itEnd, bool Cached, float& Width)
+{
+	uint32_t codePoint = 0;
+	Width = 0.0f;
+	Glyph* g = 0;
+	Glyph* previousGlyph = 0;
+	Glyph* filledGlyph = 0;
+	Glyph* outlinedGlyph = 0;
+	for (; itEnd != itCodePoint; ++itCodePoint)
+	{
+		codePoint = *itCodePoint;
+		if (Cached)
+		{
+			if (!findChar(codePoint, filledGlyph, outlinedGlyph))
+				return false;
+
+			g = outlinedGlyph ? outlinedGlyph : filledGlyph;
+		}
+		else
+		{
+			Glyph* measuredGlyph = measureChar(codePoint);
+			if (!measuredGlyph)
+				continue;
+
+			g = measuredGlyph;
+		}
+		if (!g)
+			continue;
+
+		float kerningX;
+		if (Cached)
+		{
+			if (!findKerning(previousGlyph, g, &kerningX))
+				return false;
+		}
+		else
+			getKerning(previousGlyph, g, &kerningX, 0);
+
+		Width += getAdvance(g) + kerningX;
+		previousGlyph = g;
+	}
+	if (g)
+	{
+		Width -= getAdvance(g);
+		Width += g->glyphWidth * getScale(g);
+	}
+	return true;
+}
+
+template <typename TIterator>
+bool sfttf::Font::measureHeight(TIterator itCodePoint, const TIterator& itEnd, bool Cached, float& Height)
+{
+	uint32_t codePoint = 0;
+	Glyph* g = 0;
+	Glyph* filledGlyph = 0;
+	Glyph* outlinedGlyph = 0;
+	Height = 0.0f;
+	for (; itEnd != itCodePoint; ++itCodePoint)
+	{
+		codePoint = *itCodePoint;
+		if (Cached)
+		{
+			if (!findChar(codePoint, filledGlyph, outlinedGlyph))
+				return false;
+
+			g = outlinedGlyph ? outlinedGlyph : filledGlyph;
+		}
+		else
+			g = measureChar(codePoint);
+
+		if (!g)
+			continue;
+
+		Height = std::max(Height, g->glyphHeight * getScale(g));
+	}
+	return true;
+}
+
+template <typename TIterator>
+sfttf::Font::StringBounds sfttf::Font::getStringBounds(TIterator itCodePoint, const TIterator& itEnd)
+{
+	float Width = 0.0f;
+	float Height = 0.0f;
+	float Ascent = 0.0f;
+	float Descent = 0.0f;
+	bool Measured = false;
+	if (myManager->isThreadSafe())
+	{
+		Reclaimer::Reader Read(myFontFace->myReclaimer);
+		Measured = measureBounds(itCodePoint, itEnd, true, Width, Height, Ascent, Descent);
+	}
+	if (!Measured)
+	{
+		FontManager::UseLock Lock(*myManager);
+		myFontFace->beginUse();
+		measureBounds(itCodePoint, itEnd, false, Width, Height, Ascent, Descent);
+	}
+
+	StringBounds Bounds;
+	Bounds.Width = static_cast<unsigned int>(std::ceil(Width));
+	Bounds.Height = static_cast<unsigned int>(std::ceil(Height));
+	Bounds.Ascent = static_cast<int>(std::ceil(Ascent));
+	Bounds.Descent = static_cast<int>(std::ceil(Descent));
+	return Bounds;
+}
+
+/*
+	measureWidth and measureHeight together. Ascent and Descent are
+	those of the glyphs' bitmaps, distance field glyphs without their
+	padding (see FontFace::createGlyph). They stay 0 for strings
+	without any bitmap.
+*/
+template <typename TIterator>
+bool sfttf::Font::measureBounds(TIterator itCodePoint, const TIterator& itEnd, bool Cached, float& Width, float& Height, float& Ascent, float& Descent)
+{
+	uint32_t codePoint = 0;
+	Width = 0.0f;
+	Height = 0.0f;
+	Ascent = 0.0f;
+	Descent = 0.0f;
+	bool haveBitmap = false;
+	Glyph* g = 0;
+	Glyph* previousGlyph = 0;
+	Glyph* filledGlyph = 0;
+	Glyph* outlinedGlyph = 0;
+	for (; itEnd != itCodePoint; ++itCodePoint)
+	{
+		codePoint = *itCodePoint;
+		if (Cached)
+		{
+			if (!findChar(codePoint, filledGlyph, outlinedGlyph))
+				return false;
+
+			g = outlinedGlyph ? outlinedGlyph : filledGlyph;
+		}
+		else
+		{
+			Glyph* measuredGlyph = measureChar(codePoint);
+			if (!measuredGlyph)
+				continue;
+
+			g = measuredGlyph;
+		}
+		if (!g)
+			continue;
+
+		float kerningX;
+		if (Cached)
+		{
+			if (!findKerning(previousGlyph, g, &kerningX))
+				return false;
+		}
+		else
+			getKerning(previousGlyph, g, &kerningX, 0);
+
+		Width += getAdvance(g) + kerningX;
+		previousGlyph = g;
+
+		const float Scale = getScale(g);
+		Height = std::max(Height, g->glyphHeight * Scale);
+		if (0 != g->glyphWidth && 0 != g->glyphHeight)
+		{
+			const int Top = (0 == g->Size) ? g->bitmapTop - FontFace::distanceFieldSpread : g->bitmapTop;
+			const float glyphAscent = Top * Scale;
+			const float glyphDescent = (g->glyphHeight - Top) * Scale;
+			Ascent = haveBitmap ? std::max(Ascent, glyphAscent) : glyphAscent;
+			Descent = haveBitmap ? std::max(Descent, glyphDescent) : glyphDescent;
+			haveBitmap = true;
+		}
+	}
+	if (g)
+	{
+		Width -= getAdvance(g);
+		Width += g->glyphWidth * getScale(g);
+	}
+	return true;
+}
@@ -0,0 +1,1635 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#include <sfttf/FontFace.hpp>
+#include <sfttf/Atomic.hpp>
+#include <sfttf/Glyph.hpp>
+#include <sfttf/MappedFile.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include FT_OUTLINE_H
+
+namespace
+{
+	/*
+		Cache file layout:
+		-A CacheHeader
+		-glyphCount times a CacheEntry followed by Width * Height bytes of coverage
+		 (none for glyphs without a bitmap), then for combined glyphs
+		 Width * Height bytes of outline share
+		-xAdvance is in 26.6 fixed point
+		-Everything is in the byte order of the machine that wrote it,
+		 byteOrder tells it from others
+
+		Bump cacheVersion whenever the layout or the way glyphs are
+		rendered changes.
+	*/
+	const char cacheMagic[4] = {'S', 'F', 'T', 'C'};
+	const sf::Uint32 cacheVersion = 5;
+	const sf::Uint32 cacheByteOrder = 0x01020304;
+	const sf::Uint32 cacheFreeTypeVersion = (FREETYPE_MAJOR << 16) | (FREETYPE_MINOR << 8) | FREETYPE_PATCH;
+
+	struct CacheHeader
+	{
+		char Magic[4];
+		sf::Uint32 byteOrder;
+		sf::Uint32 Version;
+		sf::Uint32 freeTypeVersion;
+		sf::Uint32 fontHash;
+		sf::Uint32 glyphCount;
+	};
+
+	struct CacheEntry
+	{
+		sf::Uint32 codePoint;
+		sf::Int32 Size;
+		sf::Int32 outlineSize;
+		sf::Int32 Combined;
+		sf::Int32 Phase;
+		sf::Uint32 glyphIndex;
+		sf::Int32 Width;
+		sf::Int32 Height;
+		sf::Int32 xAdvance;
+		sf::Int32 bitmapLeft;
+		sf::Int32 bitmapTop;
+	};
+
+	/*
+		Larger glyphs in a cache file are taken for corruption.
+	*/
+	const sf::Int32 cacheMaximumGlyphSize = 4096;
+
+	/*
+		Reads the entry at pData and finds its bitmap data, moving pData
+		past both. phaseCount is FontFace::subpixelPhases.
+		Returns false if the entry is invalid or the file ends first.
+	*/
+	bool readCacheEntry(const unsigned char*& pData, const unsigned char* pEnd, int phaseCount, CacheEntry& Entry, const unsigned char*& Coverage)
+	{
+		if (static_cast<std::size_t>(pEnd - pData) < sizeof(Entry))
+			return false;
+
+		std::memcpy(&Entry, pData, sizeof(Entry));
+		pData += sizeof(Entry);
+		if (Entry.codePoint > 0x10FFFF ||
+			Entry.Width < 0 || Entry.Width > cacheMaximumGlyphSize ||
+			Entry.Height < 0 || Entry.Height > cacheMaximumGlyphSize ||
+			Entry.Size < 0 || Entry.outlineSize < 0 ||
+			(0 != Entry.Combined && 1 != Entry.Combined) ||
+			(0 != Entry.Combined && 0 == Entry.outlineSize) ||
+			Entry.Phase < 0 || Entry.Phase > phaseCount ||
+			(0 == Entry.Size && (0 != Entry.outlineSize || 0 != Entry.Combined || 0 != Entry.Phase)))
+			return false;
+
+		Coverage = 0;
+		if (0 != Entry.Width && 0 != Entry.Height)
+		{
+			const std::size_t coverageSize = static_cast<std::size_t>(Entry.Width) * Entry.Height;
+			const std::size_t dataSize = (0 != Entry.Combined) ? 2 * coverageSize : coverageSize;
+			if (static_cast<std::size_t>(pEnd - pData) < dataSize)
+				return false;
+
+			Coverage = pData;
+			pData += dataSize;
+		}
+		return true;
+	}
+
+	/*
+		Rounds towards negative infinity, unlike /.
+	*/
+	int floorDivide(int Value, int Divisor)
+	{
+		return (Value >= 0) ? Value / Divisor : -((-Value + Divisor - 1) / Divisor);
+	}
+
+	/*
+		The pixels FreeType's rasterizer covers for Outline moved right
+		by Offset (26.6): its control box rounded out to whole pixels.
+	*/
+	void getOutlineBox(const FT_Outline& Outline, FT_Pos Offset, FT_BBox& Box)
+	{
+		if (0 == Outline.n_points)
+		{
+			Box.xMin = 0;
+			Box.yMin = 0;
+			Box.xMax = 0;
+			Box.yMax = 0;
+			return;
+		}
+		FT_Outline_Get_CBox(&Outline, &Box);
+		Box.xMin = (Box.xMin + Offset) >> 6;
+		Box.yMin = Box.yMin >> 6;
+		Box.xMax = (Box.xMax + Offset + 63) >> 6;
+		Box.yMax = (Box.yMax + 63) >> 6;
+	}
+
+	/*
+		getOutlineBox for a loaded glyph, which may also be a bitmap
+		from the font's embedded strikes.
+	*/
+	bool getSlotBox(FT_GlyphSlot Slot, FT_Pos Offset, FT_BBox& Box)
+	{
+		if (FT_GLYPH_FORMAT_OUTLINE == Slot->format)
+		{
+			getOutlineBox(Slot->outline, Offset, Box);
+			return true;
+		}
+		if (FT_GLYPH_FORMAT_BITMAP != Slot->format)
+			return false;
+
+		Box.xMin = Slot->bitmap_left;
+		Box.yMax = Slot->bitmap_top;
+		Box.xMax = Box.xMin + sfttf::GlyphAtlas::getBitmapWidth(Slot->bitmap);
+		Box.yMin = Box.yMax - sfttf::GlyphAtlas::getBitmapHeight(Slot->bitmap);
+		return true;
+	}
+
+	bool isEmptyBox(const FT_BBox& Box)
+	{
+		return Box.xMax <= Box.xMin || Box.yMax <= Box.yMin;
+	}
+
+	const float distanceInfinity = 1e20f;
+
+	/*
+		Felzenszwalb and Huttenlocher's squared distance transform,
+		done in place on Count values Stride apart.
+		The other arguments are scratch space.
+	*/
+	void transformLine(float* Values, int Count, int Stride, std::vector<float>& f, std::vector<float>& z, std::vector<int>& v)
+	{
+		f.resize(Count);
+		z.resize(Count + 1);
+		v.resize(Count);
+		for (int i = 0; i < Count; ++i)
+			f[i] = Values[i * Stride];
+
+		int k = 0;
+		v[0] = 0;
+		z[0] = -distanceInfinity;
+		z[1] = distanceInfinity;
+		for (int q = 1; q < Count; ++q)
+		{
+			float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+			while (s <= z[k])
+			{
+				--k;
+				s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+			}
+			++k;
+			v[k] = q;
+			z[k] = s;
+			z[k + 1] = distanceInfinity;
+		}
+
+		k = 0;
+		for (int q = 0; q < Count; ++q)
+		{
+			while (z[k + 1] < q)
+				++k;
+
+			Values[q * Stride] = static_cast<float>((q - v[k]) * (q - v[k])) + f[v[k]];
+		}
+	}
+
+	/*
+		Squared distance from every pixel to the nearest pixel whose
+		Inside value (1 inside the glyph, 0 outside) is Target.
+	*/
+	void squaredDistances(const std::vector<unsigned char>& Inside, unsigned char Target, int Width, int Height, std::vector<float>& Distances)
+	{
+		std::vector<float> f;
+		std::vector<float> z;
+		std::vector<int> v;
+		Distances.resize(Width * Height);
+		for (int i = 0; i < Width * Height; ++i)
+			Distances[i] = (Target == Inside[i]) ? 0.0f : distanceInfinity;
+
+		for (int x = 0; x < Width; ++x)
+			transformLine(&Distances[x], Height, Width, f, z, v);
+
+		for (int y = 0; y < Height; ++y)
+			transformLine(&Distances[y * Width], Width, 1, f, z, v);
+	}
+
+	/*
+		Makes a Width x Height distance field from a Scale times larger
+		bitmap, placed at OffsetX, OffsetY (in bitmap pixels) in the field.
+		Values are 128 on the edge, +-127 at Spread field pixels in/out.
+	*/
+	void makeDistanceField(const FT_Bitmap& Bitmap, int OffsetX, int OffsetY, int Width, int Height, int Scale, int Spread, std::vector<unsigned char>& Field)
+	{
+		const int gridWidth = Width * Scale;
+		const int gridHeight = Height * Scale;
+		std::vector<unsigned char> Inside(gridWidth * gridHeight, 0);
+		for (int y = 0; y < static_cast<int>(Bitmap.rows); ++y)
+		{
+			for (int x = 0; x < static_cast<int>(Bitmap.width); ++x)
+				Inside[(y + OffsetY) * gridWidth + x + OffsetX] = (Bitmap.buffer[y * Bitmap.pitch + x] >= 128) ? 1 : 0;
+		}
+
+		std::vector<float> toInside;
+		std::vector<float> toOutside;
+		squaredDistances(Inside, 1, gridWidth, gridHeight, toInside);
+		squaredDistances(Inside, 0, gridWidth, gridHeight, toOutside);
+
+		Field.resize(Width * Height);
+		for (int y = 0; y < Height; ++y)
+		{
+			for (int x = 0; x < Width; ++x)
+			{
+				/*
+					Sampled at the middle of the field pixel, the edge
+					being half a bitmap pixel past the last pixel in/out.
+				*/
+				const int Sample = (y * Scale + Scale / 2) * gridWidth + x * Scale + Scale / 2;
+				float Distance = (0 != Inside[Sample]) ? 0.5f - std::sqrt(toOutside[Sample]) : std::sqrt(toInside[Sample]) - 0.5f;
+				Distance /= static_cast<float>(Scale);
+
+				const float Value = 128.0f - Distance * 127.0f / static_cast<float>(Spread);
+				Field[y * Width + x] = static_cast<unsigned char>(std::max(0.0f, std::min(255.0f, Value + 0.5f)));
+			}
+		}
+	}
+}
+
+sfttf::FontFace::FontFace(FontManager* Manager, FT_Library FreeType, bool ownFreeType) : myManager(Manager),
+																						 myFreeType(FreeType),
+																						 myOwnFreeType(ownFreeType),
+																						 myHaveKerning(false),
+																						 myFontFile(0),
+																						 myFontHash(0),
+																						 myReferences(0),
+																						 myGlyphs(myReclaimer),
+																						 myMeasured(myReclaimer),
+																						 myGlyphPool(new GlyphPool),
+																						 myLruHead(0),
+																						 myLruTail(0),
+																						 myCacheSize(0),
+																						 myCacheBudget(0),
+																						 myUseStamp(0),
+																						 myClearCount(0),
+																						 myArrivalCount(0)
+{
+	std::fill(myKerningSlots, myKerningSlots + kerningTableCount, static_cast<KerningTable*>(0));
+}
+
+sfttf::FontFace::~FontFace()
+{
+	clearCache();
+	delete myGlyphPool;
+	Deinitialize();
+	if (myOwnFreeType)
+		FT_Done_FreeType(myFreeType);
+}
+
+/*
+	Lookups without the lock may still be reading the glyphs,
+	so the whole pool is retired and a new one started.
+*/
+void sfttf::FontFace::clearCache()
+{
+	myGlyphs.Clear();
+	myMeasured.Clear();
+	clearFastTables();
+	clearKerningTables();
+	myAtlas.Clear();
+	myReclaimer.Retire(&FontFace::freeGlyphPool, 0, myGlyphPool);
+	myGlyphPool = new GlyphPool;
+
+	myLruHead = 0;
+	myLruTail = 0;
+	myCacheSize = 0;
+	++myClearCount;
+
+	myPending.clear();
+	myManager->myWorkers.cancelFace(this);
+}
+
+void sfttf::FontFace::setCacheBudget(std::size_t Bytes)
+{
+	myCacheBudget = Bytes;
+	if (0 != myCacheBudget)
+		trimCache(myCacheBudget);
+}
+
+std::size_t sfttf::FontFace::getCacheBudget() const
+{
+	return myCacheBudget;
+}
+
+/*
+	Glyph records plus their area in the atlas.
+*/
+std::size_t sfttf::FontFace::getCacheSize() const
+{
+	return myCacheSize;
+}
+
+void sfttf::FontFace::unpinAll()
+{
+	for (unsigned int i = 0; i < myGlyphs.getCapacity(); ++i)
+	{
+		Glyph* g = myGlyphs.getSlot(i);
+		if (g && g->Pinned)
+		{
+			g->Pinned = false;
+			if (0 == g->Holds)
+				linkGlyph(g);
+		}
+	}
+	if (0 != myCacheBudget)
+		trimCache(myCacheBudget);
+}
+
+bool sfttf::FontFace::saveCache(const std::string& Filename)
+{
+	CacheHeader Header;
+	std::memcpy(Header.Magic, cacheMagic, sizeof(cacheMagic));
+	Header.byteOrder = cacheByteOrder;
+	Header.Version = cacheVersion;
+	Header.freeTypeVersion = cacheFreeTypeVersion;
+	Header.fontHash = getFontHash();
+	Header.glyphCount = myGlyphs.getSize();
+
+	std::ofstream File(Filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!File)
+		return false;
+
+	File.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+
+	std::vector<unsigned char> Coverage;
+	std::vector<unsigned char> outlineShare;
+	for (unsigned int i = 0; i < myGlyphs.getCapacity(); ++i)
+	{
+		const Glyph* g = myGlyphs.getSlot(i);
+		if (!g)
+			continue;
+
+		CacheEntry Entry;
+		Entry.codePoint = g->codePoint;
+		Entry.Size = g->Size;
+		Entry.outlineSize = g->outlineSize;
+		Entry.Combined = g->Combined ? 1 : 0;
+		Entry.Phase = g->Phase;
+		Entry.glyphIndex = g->glyphIndex;
+		Entry.Width = g->glyphWidth;
+		Entry.Height = g->glyphHeight;
+		if (0 != g->textureRect.GetWidth())
+		{
+			Entry.Width = g->textureRect.GetWidth();
+			Entry.Height = g->textureRect.GetHeight();
+		}
+		Entry.xAdvance = g->xAdvanceFixed;
+		Entry.bitmapLeft = g->bitmapLeft;
+		Entry.bitmapTop = g->bitmapTop;
+		File.write(reinterpret_cast<const char*>(&Entry), sizeof(Entry));
+
+		if (0 != g->textureRect.GetWidth())
+		{
+			Coverage.resize(g->textureRect.GetWidth() * g->textureRect.GetHeight());
+			outlineShare.resize(Coverage.size());
+			myAtlas.Download(g->Page, g->textureRect, &Coverage[0], g->Combined ? &outlineShare[0] : 0);
+			File.write(reinterpret_cast<const char*>(&Coverage[0]), Coverage.size());
+			if (g->Combined)
+				File.write(reinterpret_cast<const char*>(&outlineShare[0]), outlineShare.size());
+		}
+	}
+	return File.good();
+}
+
+/*
+	The file is mapped rather than read, coverage goes straight
+	from the mapping into the atlas.
+	The whole file is checked before any glyph is added, and the glyphs
+	added are removed again if one cannot be, so a file that fails to
+	load leaves the cache as it was.
+*/
+bool sfttf::FontFace::loadCache(const std::string& Filename)
+{
+	MappedFile File;
+	if (!File.Open(Filename))
+		return false;
+
+	const unsigned char* pData = File.getData();
+	const unsigned char* pEnd = pData + File.getSize();
+
+	CacheHeader Header;
+	if (static_cast<std::size_t>(pEnd - pData) < sizeof(Header))
+		return false;
+
+	std::memcpy(&Header, pData, sizeof(Header));
+	pData += sizeof(Header);
+	if (0 != std::memcmp(Header.Magic, cacheMagic, sizeof(cacheMagic)) ||
+		cacheByteOrder != Header.byteOrder ||
+		cacheVersion != Header.Version ||
+		cacheFreeTypeVersion != Header.freeTypeVersion ||
+		getFontHash() != Header.fontHash)
+		return false;
+
+	const unsigned char* const pEntries = pData;
+	CacheEntry Entry;
+	const unsigned char* Coverage;
+	for (sf::Uint32 i = 0; i < Header.glyphCount; ++i)
+	{
+		if (!readCacheEntry(pData, pEnd, subpixelPhases, Entry, Coverage))
+			return false;
+	}
+	if (pEnd != pData)
+		return false;
+
+	beginUse();
+	std::vector<GlyphKey> addedKeys;
+	pData = pEntries;
+	for (sf::Uint32 i = 0; i < Header.glyphCount; ++i)
+	{
+		readCacheEntry(pData, pEnd, subpixelPhases, Entry, Coverage);
+
+		const GlyphKey Key(Entry.codePoint, Entry.Size, Entry.outlineSize, 0 != Entry.Combined, Entry.Phase);
+		if (myGlyphs.Find(Key))
+			continue;
+
+		FT_Bitmap Bitmap;
+		std::memset(&Bitmap, 0, sizeof(Bitmap));
+		Bitmap.width = Entry.Width;
+		Bitmap.rows = Entry.Height;
+		Bitmap.pitch = Entry.Width;
+		Bitmap.num_grays = 256;
+		Bitmap.pixel_mode = FT_PIXEL_MODE_GRAY;
+		Bitmap.buffer = const_cast<unsigned char*>(Coverage);
+		const unsigned char* outlineShare = (Coverage && 0 != Entry.Combined) ? Coverage + Entry.Width * Entry.Height : 0;
+
+		Glyph* newGlyph = createGlyph(Bitmap,
+			outlineShare,
+			Entry.bitmapLeft,
+			Entry.bitmapTop,
+			Entry.xAdvance,
+			Entry.glyphIndex,
+			Entry.Size,
+			Entry.outlineSize);
+		if (!newGlyph)
+		{
+			for (std::size_t j = 0; j < addedKeys.size(); ++j)
+			{
+				Glyph* addedGlyph = myGlyphs.Find(addedKeys[j]);
+				if (addedGlyph)
+					evictGlyph(addedGlyph);
+			}
+			return false;
+		}
+
+		addGlyph(Key, newGlyph);
+		addedKeys.push_back(Key);
+	}
+	return true;
+}
+
+/*
+	The face reads straight from the mapping, which must outlive it.
+*/
+bool sfttf::FontFace::Initialize(const MappedFile& File, long faceIndex)
+{
+	if (!myRasterizer.Open(myFreeType, File, faceIndex))
+		return false;
+
+	if (FT_HAS_KERNING(myRasterizer.Face))
+	{
+		myHaveKerning = true;
+		for (unsigned int i = 0; i < kerningRange; ++i)
+			myAsciiIndices[i] = FT_Get_Char_Index(myRasterizer.Face, kerningFirst + i);
+	}
+
+	myFontFile = &File;
+	return true;
+}
+
+void sfttf::FontFace::Deinitialize()
+{
+	myRasterizer.Close();
+}
+
+/*
+	Looks Key up and renders it if it is not cached.
+
+	With Async, a glyph that is not cached is queued for the workers
+	(see GlyphWorkers) instead: 0 is returned and Pending is set until
+	collectGlyphs adds it. Glyphs the workers could not render, and every
+	glyph when there are no workers, are rendered here.
+*/
+sfttf::Glyph* sfttf::FontFace::cacheGlyph(const GlyphKey& Key, bool Async, bool& Pending)
+{
+	Pending = false;
+	Glyph* cachedGlyph = findGlyph(Key);
+	if (cachedGlyph)
+	{
+		touchGlyph(cachedGlyph);
+		return cachedGlyph;
+	}
+
+	if (Async)
+	{
+		const PendingMap::const_iterator itPending(myPending.find(Key));
+		if (myPending.end() != itPending)
+			Pending = itPending->second;
+		else if (myManager->myWorkers.Queue(this, Key))
+		{
+			myPending.insert(std::make_pair(Key, true));
+			Pending = true;
+		}
+		if (Pending)
+			return 0;
+	}
+
+	RenderedGlyph Rendered;
+	Rendered.Key = Key;
+	if (!renderGlyph(myRasterizer, Rendered))
+		return 0;
+
+	return addRendered(Rendered);
+}
+
+/*
+	True while Key is queued for the workers.
+*/
+bool sfttf::FontFace::isPending(const GlyphKey& Key) const
+{
+	const PendingMap::const_iterator itPending(myPending.find(Key));
+	return myPending.end() != itPending && itPending->second;
+}
+
+/*
+	Adds the glyphs the workers finished for this face.
+	Glyphs that arrive are new to anything laid out with placeholders,
+	which is told by myArrivalCount (see Font::LayoutGlyphs).
+	Glyphs that are not pending any more were queued before clearCache,
+	and are dropped. Glyphs handed back unstarted are no longer pending,
+	so they are queued again the next time they are used.
+*/
+void sfttf::FontFace::collectGlyphs()
+{
+	if (myPending.empty())
+		return;
+
+	std::vector<RenderedGlyph*> Done;
+	myManager->myWorkers.Collect(this, Done);
+	bool Added = false;
+	for (std::size_t i = 0; i < Done.size(); ++i)
+	{
+		RenderedGlyph* Rendered = Done[i];
+		const PendingMap::iterator itPending(myPending.find(Rendered->Key));
+		if (myPending.end() != itPending)
+		{
+			if (!Rendered->Rendered && !Rendered->Unstarted)
+				itPending->second = false;
+			else
+			{
+				myPending.erase(itPending);
+				if (Rendered->Rendered && !findGlyph(Rendered->Key) && addRendered(*Rendered))
+					Added = true;
+			}
+		}
+		delete Rendered;
+	}
+	if (Added)
+		++myArrivalCount;
+}
+
+sfttf::Glyph* sfttf::FontFace::addRendered(const RenderedGlyph& Rendered)
+{
+	Glyph* newGlyph = createGlyph(Rendered.Bitmap,
+		Rendered.outlineShare.empty() ? 0 : &Rendered.outlineShare[0],
+		Rendered.Left,
+		Rendered.Top,
+		Rendered.xAdvanceFixed,
+		Rendered.glyphIndex,
+		Rendered.Key.Size,
+		Rendered.Key.outlineSize);
+	if (!newGlyph)
+		return 0;
+
+	addGlyph(Rendered.Key, newGlyph);
+	return newGlyph;
+}
+
+/*
+	Renders the glyph for Rendered.Key with Raster.
+	Only Raster and Rendered are used, so workers can call this with
+	their own rasterizer.
+*/
+bool sfttf::FontFace::renderGlyph(Rasterizer& Raster, RenderedGlyph& Rendered)
+{
+	const GlyphKey& Key = Rendered.Key;
+	if (0 == Key.Size)
+		return renderDistanceField(Raster, Rendered);
+
+	if (0 == Key.outlineSize)
+		return renderFill(Raster, Rendered);
+
+	if (Key.Combined)
+		return renderCombined(Raster, Rendered);
+
+	return renderOutline(Raster, Rendered);
+}
+
+/*
+	Phase 0 glyphs are hinted to the pixel grid.
+	Other phases are only hinted vertically (light hinting) and moved right
+	before rendering, their advance is the unhinted one.
+*/
+bool sfttf::FontFace::renderFill(Rasterizer& Raster, RenderedGlyph& Rendered)
+{
+	const GlyphKey& Key = Rendered.Key;
+	if (!Raster.setSize(Key.Size))
+		return false;
+
+	FT_UInt glyphIndex = FT_Get_Char_Index(Raster.Face, Key.codePoint);
+	/*
+	You have two choices for glyphIndex == 0 (code point not in font):
+	-Return false
+	-Ignore it. This will typically show a 'box'
+
+	if (0 == glyphIndex)
+		return false;
+	*/
+
+	if (0 != FT_Load_Glyph(Raster.Face, glyphIndex, (0 == Key.Phase) ? FT_LOAD_RENDER : FT_LOAD_TARGET_LIGHT))
+		return false;
+
+	const FT_GlyphSlot Slot = Raster.Face->glyph;
+	int xAdvanceFixed = Slot->metrics.horiAdvance;
+	if (0 != Key.Phase)
+	{
+		if (FT_GLYPH_FORMAT_OUTLINE == Slot->format)
+			FT_Outline_Translate(&Slot->outline, getPhaseOffset(Key.Phase), 0);
+
+		if (0 != FT_Render_Glyph(Slot, FT_RENDER_MODE_NORMAL))
+			return false;
+
+		xAdvanceFixed = (Slot->linearHoriAdvance + 512) >> 10;
+	}
+
+	Rendered.setBitmap(Slot->bitmap);
+	Rendered.Left = Slot->bitmap_left;
+	Rendered.Top = Slot->bitmap_top;
+	Rendered.xAdvanceFixed = xAdvanceFixed;
+	Rendered.glyphIndex = glyphIndex;
+	return true;
+}
+
+/*
+	See renderFill for phases.
+*/
+bool sfttf::FontFace::renderOutline(Rasterizer& Raster, RenderedGlyph& Rendered)
+{
+	const GlyphKey& Key = Rendered.Key;
+	if (!Raster.setSize(Key.Size))
+		return false;
+
+	Raster.setOutlineSize(Key.outlineSize);
+	FT_UInt glyphIndex = FT_Get_Char_Index(Raster.Face, Key.codePoint);
+	/*
+	You have two choices for glyphIndex == 0 (code point not in font):
+	-Return false
+	-Ignore it. This will typically show a 'box'
+
+	if (0 == glyphIndex)
+		return false;
+	*/
+
+	if (0 != FT_Load_Glyph(Raster.Face, glyphIndex, (0 == Key.Phase) ? FT_LOAD_NO_BITMAP : FT_LOAD_NO_BITMAP | FT_LOAD_TARGET_LIGHT))
+		return false;
+
+	if (!(Raster.Face->glyph->format & FT_GLYPH_FORMAT_OUTLINE))
+		return false;
+
+	FT_Glyph Glyph = 0;
+	if (0 != FT_Get_Glyph(Raster.Face->glyph, &Glyph))
+		return false;
+
+	/*
+	This will insure FT_Done_Glyph is called.
+	FT_Glyph is a pointer.
+	FT_Glyph_Stroke/FT_Glyph_To_Bitmap will actually change where
+	the FT_Glyph points, and (optionally) call FT_Done_Glyph on the old one.
+	This is why FreeGlyph must take the address of the FT_Glyph.
+	Otherwise, we could leak or FT_Done_Glyph could be called twice (crash).
+	*/
+	FreeGlyph f(&Glyph);
+	if (0 != FT_Glyph_Stroke(&Glyph, Raster.Stroker, 1))
+		return false;
+
+	FT_Vector Origin;
+	Origin.x = getPhaseOffset(Key.Phase);
+	Origin.y = 0;
+	if (0 != FT_Glyph_To_Bitmap(&Glyph, FT_RENDER_MODE_NORMAL, &Origin, 1))
+		return false;
+
+	/*
+	See the FreeType docs/demos.
+	*/
+	FT_BitmapGlyph bitmapGlyph = reinterpret_cast<FT_BitmapGlyph>(Glyph);
+	Rendered.setBitmap(bitmapGlyph->bitmap);
+	Rendered.Left = bitmapGlyph->left;
+	Rendered.Top = bitmapGlyph->top;
+	Rendered.xAdvanceFixed = getAdvance(Raster, Glyph, Key.Phase);
+	Rendered.glyphIndex = glyphIndex;
+	return true;
+}
+
+/*
+	Renders the fill and the outline of a character into one glyph:
+	the outline is drawn over the fill, like drawString does with separate
+	glyphs, and the outline's share of each pixel goes in the color channels.
+*/
+bool sfttf::FontFace::renderCombined(Rasterizer& Raster, RenderedGlyph& Rendered)
+{
+	const GlyphKey& Key = Rendered.Key;
+	if (!Raster.setSize(Key.Size))
+		return false;
+
+	Raster.setOutlineSize(Key.outlineSize);
+	FT_UInt glyphIndex = FT_Get_Char_Index(Raster.Face, Key.codePoint);
+	if (0 != FT_Load_Glyph(Raster.Face, glyphIndex, (0 == Key.Phase) ? FT_LOAD_NO_BITMAP : FT_LOAD_NO_BITMAP | FT_LOAD_TARGET_LIGHT))
+		return false;
+
+	if (!(Raster.Face->glyph->format & FT_GLYPH_FORMAT_OUTLINE))
+		return false;
+
+	/*
+	See renderOutline for why FreeGlyph takes the address.
+	*/
+	FT_Glyph Fill = 0;
+	if (0 != FT_Get_Glyph(Raster.Face->glyph, &Fill))
+		return false;
+
+	FreeGlyph f(&Fill);
+	FT_Glyph Outline = 0;
+	if (0 != FT_Glyph_Copy(Fill, &Outline))
+		return false;
+
+	FreeGlyph o(&Outline);
+	if (0 != FT_Glyph_Stroke(&Outline, Raster.Stroker, 1))
+		return false;
+
+	FT_Vector Origin;
+	Origin.x = getPhaseOffset(Key.Phase);
+	Origin.y = 0;
+	if (0 != FT_Glyph_To_Bitmap(&Fill, FT_RENDER_MODE_NORMAL, &Origin, 1) ||
+		0 != FT_Glyph_To_Bitmap(&Outline, FT_RENDER_MODE_NORMAL, &Origin, 1))
+		return false;
+
+	const FT_BitmapGlyph fillGlyph = reinterpret_cast<FT_BitmapGlyph>(Fill);
+	const FT_BitmapGlyph outlineGlyph = reinterpret_cast<FT_BitmapGlyph>(Outline);
+	const FT_Bitmap& fillBitmap = fillGlyph->bitmap;
+	const FT_Bitmap& outlineBitmap = outlineGlyph->bitmap;
+
+	/*
+	The outline is normally larger than the fill, but take both to be safe.
+	Empty bitmaps do not count.
+	*/
+	int Left = outlineGlyph->left;
+	int Top = outlineGlyph->top;
+	int Right = Left + outlineBitmap.width;
+	int Bottom = Top - outlineBitmap.rows;
+	if (0 == outlineBitmap.width || 0 == outlineBitmap.rows)
+	{
+		Left = fillGlyph->left;
+		Top = fillGlyph->top;
+		Right = Left + fillBitmap.width;
+		Bottom = Top - fillBitmap.rows;
+	}
+	else if (0 != fillBitmap.width && 0 != fillBitmap.rows)
+	{
+		Left = std::min(Left, static_cast<int>(fillGlyph->left));
+		Top = std::max(Top, static_cast<int>(fillGlyph->top));
+		Right = std::max(Right, static_cast<int>(fillGlyph->left + fillBitmap.width));
+		Bottom = std::min(Bottom, static_cast<int>(fillGlyph->top - fillBitmap.rows));
+	}
+	const int Width = Right - Left;
+	const int Height = Top - Bottom;
+
+	std::vector<unsigned char>& Coverage = Rendered.Pixels;
+	std::vector<unsigned char>& outlineShare = Rendered.outlineShare;
+	Coverage.assign(Width * Height, 0);
+	outlineShare.assign(Width * Height, 0);
+	for (int y = 0; y < Height; ++y)
+	{
+		for (int x = 0; x < Width; ++x)
+		{
+			unsigned int fillAlpha = 0;
+			unsigned int outlineAlpha = 0;
+			const int fillX = Left + x - fillGlyph->left;
+			const int fillY = fillGlyph->top - Top + y;
+			if (fillX >= 0 && fillX < static_cast<int>(fillBitmap.width) && fillY >= 0 && fillY < static_cast<int>(fillBitmap.rows))
+				fillAlpha = fillBitmap.buffer[fillY * fillBitmap.pitch + fillX];
+
+			const int outlineX = Left + x - outlineGlyph->left;
+			const int outlineY = outlineGlyph->top - Top + y;
+			if (outlineX >= 0 && outlineX < static_cast<int>(outlineBitmap.width) && outlineY >= 0 && outlineY < static_cast<int>(outlineBitmap.rows))
+				outlineAlpha = outlineBitmap.buffer[outlineY * outlineBitmap.pitch + outlineX];
+
+			const unsigned int Alpha = outlineAlpha + fillAlpha * (255 - outlineAlpha) / 255;
+			if (0 == Alpha)
+				continue;
+
+			Coverage[y * Width + x] = static_cast<unsigned char>(Alpha);
+			outlineShare[y * Width + x] = static_cast<unsigned char>(outlineAlpha * 255 / Alpha);
+		}
+	}
+
+	Rendered.setGrayBitmap(Width, Height);
+	Rendered.Left = Left;
+	Rendered.Top = Top;
+	Rendered.xAdvanceFixed = getAdvance(Raster, Outline, Key.Phase);
+	Rendered.glyphIndex = glyphIndex;
+	return true;
+}
+
+/*
+	The field is measured on a bitmap distanceFieldOversampling times larger
+	than distanceFieldSize, its corners on whole pixels of distanceFieldSize.
+*/
+bool sfttf::FontFace::renderDistanceField(Rasterizer& Raster, RenderedGlyph& Rendered)
+{
+	const int Scale = distanceFieldOversampling;
+	const int Spread = distanceFieldSpread;
+	if (!Raster.setSize(distanceFieldSize * Scale))
+		return false;
+
+	FT_UInt glyphIndex = FT_Get_Char_Index(Raster.Face, Rendered.Key.codePoint);
+	if (0 != FT_Load_Glyph(Raster.Face, glyphIndex, FT_LOAD_RENDER))
+		return false;
+
+	const FT_GlyphSlot Slot = Raster.Face->glyph;
+	const int bitmapWidth = Slot->bitmap.width;
+	const int bitmapRows = Slot->bitmap.rows;
+
+	int Left = 0;
+	int Top = 0;
+	int Width = 0;
+	int Height = 0;
+	Rendered.Pixels.clear();
+	if (0 != bitmapWidth && 0 != bitmapRows)
+	{
+		Left = floorDivide(Slot->bitmap_left, Scale) - Spread;
+		Top = -floorDivide(-Slot->bitmap_top, Scale) + Spread;
+		const int Right = -floorDivide(-(Slot->bitmap_left + bitmapWidth), Scale) + Spread;
+		const int Bottom = floorDivide(Slot->bitmap_top - bitmapRows, Scale) - Spread;
+
+		Width = Right - Left;
+		Height = Top - Bottom;
+		makeDistanceField(Slot->bitmap,
+			Slot->bitmap_left - Left * Scale,
+			Top * Scale - Slot->bitmap_top,
+			Width,
+			Height,
+			Scale,
+			Spread,
+			Rendered.Pixels);
+	}
+
+	Rendered.setGrayBitmap(Width, Height);
+	Rendered.Left = Left;
+	Rendered.Top = Top;
+	Rendered.xAdvanceFixed = Slot->metrics.horiAdvance / Scale;
+	Rendered.glyphIndex = glyphIndex;
+	return true;
+}
+
+/*
+	The metrics of Key's glyph without rendering it: the cached glyph
+	if there is one, otherwise a glyph record without a texture from
+	measureGlyph, kept in myMeasured.
+	Returns 0 if the glyph cannot be loaded.
+*/
+sfttf::Glyph* sfttf::FontFace::getMetrics(const GlyphKey& Key)
+{
+	Glyph* g = myGlyphs.Find(Key);
+	if (!g)
+		g = myMeasured.Find(Key);
+
+	if (g)
+	{
+		touchGlyph(g);
+		return g;
+	}
+
+	g = myGlyphPool->Allocate();
+	if (!measureGlyph(myRasterizer, Key, *g))
+	{
+		myGlyphPool->Free(g);
+		return 0;
+	}
+	g->lastUsed = myUseStamp;
+	g->Measured = true;
+
+	myMeasured.Insert(Key, g);
+	linkGlyph(g);
+	myCacheSize += getGlyphMemory(g);
+
+	if (0 != myCacheBudget && myCacheSize > myCacheBudget)
+		trimCache(myCacheBudget);
+
+	if (0 != myManager->myCacheBudget)
+		myManager->trimCaches();
+
+	return g;
+}
+
+/*
+	Fills Metrics with what renderGlyph would make of Key, short of the
+	bitmap: the glyph is loaded the same way but not rendered, its bitmap
+	size comes from the outline's control box (see getOutlineBox).
+	Outlines are still stroked, as the stroke changes the advance.
+*/
+bool sfttf::FontFace::measureGlyph(Rasterizer& Raster, const GlyphKey& Key, Glyph& Metrics)
+{
+	const int Scale = distanceFieldOversampling;
+	const int Spread = distanceFieldSpread;
+	if (!Raster.setSize((0 == Key.Size) ? distanceFieldSize * Scale : Key.Size))
+		return false;
+
+	FT_UInt glyphIndex = FT_Get_Char_Index(Raster.Face, Key.codePoint);
+	FT_Int32 loadFlags = (0 == Key.Phase) ? FT_LOAD_DEFAULT : FT_LOAD_TARGET_LIGHT;
+	if (0 != Key.outlineSize)
+		loadFlags |= FT_LOAD_NO_BITMAP;
+
+	if (0 != FT_Load_Glyph(Raster.Face, glyphIndex, loadFlags))
+		return false;
+
+	const FT_GlyphSlot Slot = Raster.Face->glyph;
+	const FT_Pos Offset = getPhaseOffset(Key.Phase);
+	FT_BBox Box;
+	int xAdvanceFixed = 0;
+	if (0 == Key.outlineSize)
+	{
+		if (!getSlotBox(Slot, Offset, Box))
+			return false;
+
+		xAdvanceFixed = Slot->metrics.horiAdvance;
+		if (0 != Key.Phase)
+			xAdvanceFixed = (Slot->linearHoriAdvance + 512) >> 10;
+	}
+	else
+	{
+		if (!(Slot->format & FT_GLYPH_FORMAT_OUTLINE))
+			return false;
+
+		Raster.setOutlineSize(Key.outlineSize);
+		FT_Glyph Glyph = 0;
+		if (0 != FT_Get_Glyph(Slot, &Glyph))
+			return false;
+
+		/*
+		See renderOutline for why FreeGlyph takes the address.
+		*/
+		FreeGlyph f(&Glyph);
+		if (0 != FT_Glyph_Stroke(&Glyph, Raster.Stroker, 1))
+			return false;
+
+		getOutlineBox(reinterpret_cast<FT_OutlineGlyph>(Glyph)->outline, Offset, Box);
+		xAdvanceFixed = getAdvance(Raster, Glyph, Key.Phase);
+
+		/*
+		Like renderCombined, the fill counts too.
+		*/
+		if (Key.Combined)
+		{
+			FT_BBox fillBox;
+			getOutlineBox(Slot->outline, Offset, fillBox);
+			if (isEmptyBox(Box))
+				Box = fillBox;
+			else if (!isEmptyBox(fillBox))
+			{
+				Box.xMin = std::min(Box.xMin, fillBox.xMin);
+				Box.yMin = std::min(Box.yMin, fillBox.yMin);
+				Box.xMax = std::max(Box.xMax, fillBox.xMax);
+				Box.yMax = std::max(Box.yMax, fillBox.yMax);
+			}
+		}
+	}
+
+	int Left = static_cast<int>(Box.xMin);
+	int Top = static_cast<int>(Box.yMax);
+	int Width = static_cast<int>(Box.xMax - Box.xMin);
+	int Height = static_cast<int>(Box.yMax - Box.yMin);
+	if (0 == Key.Size)
+	{
+		/*
+			See renderDistanceField for the padded box, and createGlyph
+			for the padding not being part of the glyph.
+		*/
+		xAdvanceFixed /= Scale;
+		Left = 0;
+		Top = 0;
+		Width = 0;
+		Height = 0;
+		if (!isEmptyBox(Box))
+		{
+			Left = floorDivide(static_cast<int>(Box.xMin), Scale) - Spread;
+			Top = -floorDivide(static_cast<int>(-Box.yMax), Scale) + Spread;
+			const int Right = -floorDivide(static_cast<int>(-Box.xMax), Scale) + Spread;
+			const int Bottom = floorDivide(static_cast<int>(Box.yMin), Scale) - Spread;
+			Width = Right - Left - 2 * Spread;
+			Height = Top - Bottom - 2 * Spread;
+		}
+	}
+
+	Metrics.Setup(static_cast<unsigned int>(Width),
+		static_cast<unsigned int>(Height),
+		Left,
+		Top,
+		xAdvanceFixed,
+		glyphIndex,
+		Key.Size,
+		Key.outlineSize);
+	Metrics.Page = 0;
+	Metrics.textureRect = sf::IntRect(0, 0, 0, 0);
+	Metrics.codePoint = Key.codePoint;
+	Metrics.Combined = Key.Combined;
+	Metrics.Phase = Key.Phase;
+	Metrics.lruPrevious = 0;
+	Metrics.lruNext = 0;
+	Metrics.lastUsed = 0;
+	Metrics.Pinned = false;
+	Metrics.Measured = false;
+	Metrics.Holds = 0;
+	return true;
+}
+
+sfttf::Glyph* sfttf::FontFace::getGlyph(uint32_t codePoint, int Size, int Phase)
+{
+	return findGlyph(GlyphKey(codePoint, Size, 0, false, Phase));
+}
+
+sfttf::Glyph* sfttf::FontFace::getGlyphOutline(uint32_t codePoint, int Size, int outlineSize, int Phase)
+{
+	return findGlyph(GlyphKey(codePoint, Size, outlineSize, false, Phase));
+}
+
+sfttf::Glyph* sfttf::FontFace::getGlyphCombined(uint32_t codePoint, int Size, int outlineSize, int Phase)
+{
+	return findGlyph(GlyphKey(codePoint, Size, outlineSize, true, Phase));
+}
+
+/*
+	How far glyphs of a phase are moved right, in 26.6 fixed point.
+*/
+FT_Pos sfttf::FontFace::getPhaseOffset(int Phase)
+{
+	if (0 == Phase)
+		return 0;
+
+	return (Phase - 1) * 64 / subpixelPhases;
+}
+
+/*
+	The advance of an FT_Glyph loaded with Raster in 26.6 fixed point,
+	unhinted for subpixel phases.
+*/
+int sfttf::FontFace::getAdvance(const Rasterizer& Raster, FT_Glyph Glyph, int Phase)
+{
+	if (0 == Phase)
+		return Glyph->advance.x >> 10;
+
+	return (Raster.Face->glyph->linearHoriAdvance + 512) >> 10;
+}
+
+/*
+	Looks Key up in its FastTable if it has one, in myGlyphs otherwise.
+*/
+sfttf::Glyph* sfttf::FontFace::findGlyph(const GlyphKey& Key)
+{
+	if (Key.codePoint >= fastTableSize)
+		return myGlyphs.Find(Key);
+
+	Glyph*& g = getFastTable(Key.Size, Key.outlineSize, Key.Combined, Key.Phase)->Glyphs[Key.codePoint];
+	if (!g)
+		g = myGlyphs.Find(Key);
+
+	return g;
+}
+
+/*
+	Returns the FastTable for a size, outline size (0 for filled glyphs),
+	combined flag and phase, moving it to the front of myFastTables.
+*/
+sfttf::FontFace::FastTable* sfttf::FontFace::getFastTable(int Size, int outlineSize, bool Combined, int Phase)
+{
+	if (!myFastTables.empty())
+	{
+		FastTable* Table = myFastTables.front();
+		if (Table->Size == Size && Table->outlineSize == outlineSize && Table->Combined == Combined && Table->Phase == Phase)
+			return Table;
+	}
+
+	FastTableList::iterator itTable(myFastTables.begin());
+	const FastTableList::iterator itEnd(myFastTables.end());
+	for (; itEnd != itTable; ++itTable)
+	{
+		FastTable* Table = *itTable;
+		if (Table->Size == Size && Table->outlineSize == outlineSize && Table->Combined == Combined && Table->Phase == Phase)
+		{
+			std::rotate(myFastTables.begin(), itTable, itTable + 1);
+			return Table;
+		}
+	}
+
+	FastTable* Table = 0;
+	if (myFastTables.size() < fastTableCount)
+	{
+		Table = new FastTable;
+		myFastTables.insert(myFastTables.begin(), Table);
+	}
+	else
+	{
+		Table = myFastTables.back();
+		std::rotate(myFastTables.begin(), myFastTables.end() - 1, myFastTables.end());
+	}
+	Table->Size = Size;
+	Table->outlineSize = outlineSize;
+	Table->Combined = Combined;
+	Table->Phase = Phase;
+	std::fill(Table->Glyphs, Table->Glyphs + fastTableSize, static_cast<Glyph*>(0));
+	return Table;
+}
+
+void sfttf::FontFace::clearFastTables()
+{
+	while (!myFastTables.empty())
+	{
+		delete myFastTables.back();
+		myFastTables.pop_back();
+	}
+}
+
+unsigned int sfttf::FontFace::getKerningSlot(int Size, bool Unfitted)
+{
+	return (static_cast<unsigned int>(Size) * 2 + (Unfitted ? 1 : 0)) % kerningTableCount;
+}
+
+/*
+	Returns the KerningTable for a size and kerning mode, replacing the
+	table of another size in its slot. Returns 0 if the size cannot be set.
+*/
+sfttf::FontFace::KerningTable* sfttf::FontFace::getKerningTable(int Size, bool Unfitted)
+{
+	KerningTable*& Slot = myKerningSlots[getKerningSlot(Size, Unfitted)];
+	if (0 != Slot && Slot->Size == Size && Slot->Unfitted == Unfitted)
+		return Slot;
+
+	if (!myRasterizer.setSize(Size))
+		return 0;
+
+	/*
+		A published table is only ever given new rows, a table of
+		another size is replaced by a new table in its slot.
+	*/
+	KerningTable* Table = new KerningTable;
+	Table->Size = Size;
+	Table->Unfitted = Unfitted;
+	std::fill(Table->asciiRows, Table->asciiRows + kerningRange, static_cast<Kerning*>(0));
+	if (0 != Slot)
+		myReclaimer.Retire(&FontFace::freeKerningTable, 0, Slot);
+
+	atomicStore(Slot, Table);
+	return Table;
+}
+
+void sfttf::FontFace::clearKerningTables()
+{
+	for (unsigned int i = 0; i < kerningTableCount; ++i)
+	{
+		KerningTable* oldTable = myKerningSlots[i];
+		if (0 != oldTable)
+		{
+			atomicStore(myKerningSlots[i], static_cast<KerningTable*>(0));
+			myReclaimer.Retire(&FontFace::freeKerningTable, 0, oldTable);
+		}
+	}
+}
+
+/*
+	Called at the start of every public call that uses glyphs.
+	Everything touched from here until the next call is protected
+	from eviction, since it may still be referenced (a Font's batch, kerning).
+	Glyphs the workers finished are added here.
+*/
+void sfttf::FontFace::beginUse()
+{
+	myUseStamp = ++myManager->myUseStamp;
+	myReclaimer.Reclaim();
+	collectGlyphs();
+}
+
+void sfttf::FontFace::addGlyph(const GlyphKey& Key, Glyph* g)
+{
+	g->codePoint = Key.codePoint;
+	g->Combined = Key.Combined;
+	g->Phase = Key.Phase;
+	g->lruPrevious = 0;
+	g->lruNext = 0;
+	g->lastUsed = myUseStamp;
+	g->Pinned = false;
+	g->Measured = false;
+	g->Holds = 0;
+
+	Glyph* measuredGlyph = myMeasured.Find(Key);
+	if (measuredGlyph)
+		evictGlyph(measuredGlyph);
+
+	myGlyphs.Insert(Key, g);
+	linkGlyph(g);
+	myCacheSize += getGlyphMemory(g);
+
+	if (0 != myCacheBudget && myCacheSize > myCacheBudget)
+		trimCache(myCacheBudget);
+
+	if (0 != myManager->myCacheBudget)
+		myManager->trimCaches();
+}
+
+/*
+	Moves g to the head of the LRU list, once per call at most.
+*/
+void sfttf::FontFace::touchGlyph(Glyph* g)
+{
+	if (g->lastUsed == myUseStamp)
+		return;
+
+	g->lastUsed = myUseStamp;
+	if (g->Pinned || 0 != g->Holds || myLruHead == g)
+		return;
+
+	unlinkGlyph(g);
+	linkGlyph(g);
+}
+
+void sfttf::FontFace::pinGlyph(Glyph* g)
+{
+	if (!g || g->Pinned)
+		return;
+
+	if (0 == g->Holds)
+		unlinkGlyph(g);
+
+	g->Pinned = true;
+}
+
+void sfttf::FontFace::holdGlyph(Glyph* g)
+{
+	if (0 == g->Holds++ && !g->Pinned)
+		unlinkGlyph(g);
+}
+
+/*
+	A glyph no longer held goes back to the list as just used.
+*/
+void sfttf::FontFace::releaseGlyph(Glyph* g)
+{
+	if (0 != --g->Holds || g->Pinned)
+		return;
+
+	g->lastUsed = myUseStamp;
+	linkGlyph(g);
+}
+
+void sfttf::FontFace::linkGlyph(Glyph* g)
+{
+	g->lruPrevious = 0;
+	g->lruNext = myLruHead;
+	if (myLruHead)
+		myLruHead->lruPrevious = g;
+	else
+		myLruTail = g;
+
+	myLruHead = g;
+}
+
+void sfttf::FontFace::unlinkGlyph(Glyph* g)
+{
+	if (g->lruPrevious)
+		g->lruPrevious->lruNext = g->lruNext;
+	else
+		myLruHead = g->lruNext;
+
+	if (g->lruNext)
+		g->lruNext->lruPrevious = g->lruPrevious;
+	else
+		myLruTail = g->lruPrevious;
+
+	g->lruPrevious = 0;
+	g->lruNext = 0;
+}
+
+/*
+	Removes g from every structure that refers to it, and retires it
+	to be returned to myGlyphPool once no lookup can be reading it.
+*/
+void sfttf::FontFace::evictGlyph(Glyph* g)
+{
+	if (!g->Pinned && 0 == g->Holds)
+		unlinkGlyph(g);
+
+	const GlyphKey Key(g->codePoint, g->Size, g->outlineSize, g->Combined, g->Phase);
+	if (g->Measured)
+		myMeasured.Erase(Key);
+	else
+		myGlyphs.Erase(Key);
+
+	if (!g->Measured && g->codePoint < fastTableSize)
+	{
+		FastTableList::iterator itTable(myFastTables.begin());
+		const FastTableList::iterator itEnd(myFastTables.end());
+		for (; itEnd != itTable; ++itTable)
+		{
+			FastTable* Table = *itTable;
+			if (Table->Size == g->Size && Table->outlineSize == g->outlineSize && Table->Combined == g->Combined && Table->Phase == g->Phase)
+				Table->Glyphs[g->codePoint] = 0;
+		}
+	}
+	if (0 != g->textureRect.GetWidth())
+		myAtlas.Free(g->Page, g->textureRect);
+
+	myCacheSize -= getGlyphMemory(g);
+	myReclaimer.Retire(&FontFace::freeGlyph, myGlyphPool, g);
+}
+
+/*
+	The glyph that would be evicted next, or 0 if there is none
+	(everything is pinned or in use by the current call).
+	The current call is the last one to take a stamp from the manager,
+	whichever face it uses: once another call starts, the glyphs this
+	face's last call used can be evicted by the manager's budget too.
+*/
+sfttf::Glyph* sfttf::FontFace::getLeastRecentlyUsed() const
+{
+	if (!myLruTail || myLruTail->lastUsed == myManager->myUseStamp)
+		return 0;
+
+	return myLruTail;
+}
+
+void sfttf::FontFace::trimCache(std::size_t Budget)
+{
+	while (myCacheSize > Budget)
+	{
+		Glyph* g = getLeastRecentlyUsed();
+		if (!g)
+			break;
+
+		evictGlyph(g);
+	}
+}
+
+std::size_t sfttf::FontFace::getGlyphMemory(const Glyph* g)
+{
+	return sizeof(Glyph) + g->textureRect.GetWidth() * g->textureRect.GetHeight() * (g->Combined ? 2 : 1);
+}
+
+/*
+	Owner is the pool the glyph came from, clearCache may have
+	replaced myGlyphPool since.
+*/
+void sfttf::FontFace::freeGlyph(void* Owner, void* Object)
+{
+	static_cast<GlyphPool*>(Owner)->Free(static_cast<Glyph*>(Object));
+}
+
+void sfttf::FontFace::freeGlyphPool(void* /*Owner*/, void* Object)
+{
+	delete static_cast<GlyphPool*>(Object);
+}
+
+void sfttf::FontFace::freeKerningTable(void* /*Owner*/, void* Object)
+{
+	KerningTable* Table = static_cast<KerningTable*>(Object);
+	for (unsigned int i = 0; i < kerningRange; ++i)
+		delete[] Table->asciiRows[i];
+
+	delete Table;
+}
+
+/*
+	32-bit FNV-1a of the font file and face index,
+	computed the first time it is needed.
+*/
+sf::Uint32 sfttf::FontFace::getFontHash()
+{
+	if (0 != myFontHash)
+		return myFontHash;
+
+	sf::Uint32 Hash = 2166136261u;
+	const unsigned char* pData = myFontFile->getData();
+	const unsigned char* pEnd = pData + myFontFile->getSize();
+	for (; pEnd != pData; ++pData)
+	{
+		Hash ^= *pData;
+		Hash *= 16777619u;
+	}
+	const sf::Uint32 faceIndex = static_cast<sf::Uint32>(myRasterizer.Face->face_index);
+	for (unsigned int i = 0; i < 4; ++i)
+	{
+		Hash ^= (faceIndex >> (i * 8)) & 0xff;
+		Hash *= 16777619u;
+	}
+	myFontHash = Hash;
+	return myFontHash;
+}
+
+/*
+	Creates a glyph and copies its bitmap into the atlas.
+	outlineShare is only given for combined glyphs.
+*/
+sfttf::Glyph* sfttf::FontFace::createGlyph(const FT_Bitmap& Bitmap, const unsigned char* outlineShare, int Left, int Top, int xAdvanceFixed, unsigned int Index, int Size, int outlineSize)
+{
+	Glyph* newGlyph = myGlyphPool->Allocate();
+	newGlyph->Setup(Bitmap,
+		Left,
+		Top,
+		xAdvanceFixed,
+		Index,
+		Size,
+		outlineSize);
+
+	newGlyph->Page = 0;
+	newGlyph->textureRect = sf::IntRect(0, 0, 0, 0);
+	/*
+		The padding around distance fields is not part of the glyph.
+	*/
+	if (0 == Size && 0 != Bitmap.width && 0 != Bitmap.rows)
+	{
+		newGlyph->glyphWidth -= 2 * distanceFieldSpread;
+		newGlyph->glyphHeight -= 2 * distanceFieldSpread;
+	}
+	/*
+		Certain font 'characters' will not have a texture but will have
+		other information we need.
+
+		A good example is the space character.
+	*/
+	const unsigned int Width = GlyphAtlas::getBitmapWidth(Bitmap);
+	const unsigned int Height = GlyphAtlas::getBitmapHeight(Bitmap);
+	if (0 != Width && 0 != Height)
+	{
+		if (!myAtlas.Allocate(Width, Height, 0 != outlineShare, newGlyph->Page, newGlyph->textureRect))
+		{
+			myGlyphPool->Free(newGlyph);
+			return 0;
+		}
+		myAtlas.Upload(newGlyph->Page, newGlyph->textureRect, Bitmap, outlineShare);
+	}
+	return newGlyph;
+}
+
+/*
+	getKerning for lookups without the lock (see Font::getStringWidth).
+	Only pairs of printable ASCII characters whose row is filled at the
+	size are known, false is returned for the others.
+*/
+bool sfttf::FontFace::findKerning(const Glyph* leftGlyph, const Glyph* rightGlyph, int Size, bool Unfitted, int* offsetX, int* offsetY) const
+{
+	if (offsetX)
+		*offsetX = 0;
+
+	if (offsetY)
+		*offsetY = 0;
+
+	if (!myHaveKerning || !leftGlyph || !rightGlyph)
+		return true;
+
+	const unsigned int Left = leftGlyph->codePoint - kerningFirst;
+	const unsigned int Right = rightGlyph->codePoint - kerningFirst;
+	if (Left >= kerningRange || Right >= kerningRange)
+		return false;
+
+	const KerningTable* Table = atomicLoad(myKerningSlots[getKerningSlot(Size, Unfitted)]);
+	if (0 == Table || Table->Size != Size || Table->Unfitted != Unfitted)
+		return false;
+
+	const Kerning* Row = atomicLoad(Table->asciiRows[Left]);
+	if (0 == Row)
+		return false;
+
+	if (offsetX)
+		*offsetX = static_cast<int>(Row[Right].X);
+
+	if (offsetY)
+		*offsetY = static_cast<int>(Row[Right].Y);
+
+	return true;
+}
+
+/*
+	This gets the relative offsets for kerning, in 26.6 fixed point.
+	Unfitted offsets are not rounded to whole pixels.
+*/
+void sfttf::FontFace::getKerning(Glyph* leftGlyph, Glyph* rightGlyph, int Size, bool Unfitted, int* offsetX, int* offsetY)
+{
+	if (offsetX)
+		*offsetX = 0;
+
+	if (offsetY)
+		*offsetY = 0;
+
+	if (!myHaveKerning || !leftGlyph || !rightGlyph)
+		return;
+
+	KerningTable* Table = getKerningTable(Size, Unfitted);
+	if (!Table)
+		return;
+
+	Kerning k;
+	const unsigned int Left = leftGlyph->codePoint - kerningFirst;
+	const unsigned int Right = rightGlyph->codePoint - kerningFirst;
+	if (Left < kerningRange && Right < kerningRange)
+	{
+		Kerning* Row = Table->asciiRows[Left];
+		if (0 == Row)
+		{
+			Row = new Kerning[kerningRange];
+			const bool haveSize = myRasterizer.setSize(Size);
+			FT_Vector Delta;
+			for (unsigned int i = 0; i < kerningRange; ++i)
+			{
+				Row[i].X = 0;
+				Row[i].Y = 0;
+				if (haveSize && 0 == FT_Get_Kerning(myRasterizer.Face, myAsciiIndices[Left], myAsciiIndices[i], Unfitted ? FT_KERNING_UNFITTED : FT_KERNING_DEFAULT, &Delta))
+				{
+					Row[i].X = Delta.x;
+					Row[i].Y = Delta.y;
+				}
+			}
+			atomicStore(Table->asciiRows[Left], Row);
+		}
+		k = Row[Right];
+	}
+	else
+	{
+		const std::pair<unsigned int, unsigned int> Pair(leftGlyph->glyphIndex, rightGlyph->glyphIndex);
+		KerningMap::iterator itPair = Table->otherPairs.find(Pair);
+		if (Table->otherPairs.end() == itPair)
+		{
+			FT_Vector Delta;
+			k.X = 0;
+			k.Y = 0;
+			if (myRasterizer.setSize(Size) && 0 == FT_Get_Kerning(myRasterizer.Face, Pair.first, Pair.second, Unfitted ? FT_KERNING_UNFITTED : FT_KERNING_DEFAULT, &Delta))
+			{
+				k.X = Delta.x;
+				k.Y = Delta.y;
+			}
+			itPair = Table->otherPairs.insert(std::make_pair(Pair, k)).first;
+		}
+		k = itPair->second;
+	}
+	if (offsetX)
+		*offsetX = static_cast<int>(k.X);
+
+	if (offsetY)
+		*offsetY = static_cast<int>(k.Y);
+}
+
+/*
+	The font's ascender and the distance between baselines at Size,
+	rounded up to whole pixels.
+*/
+bool sfttf::FontFace::getLineMetrics(int Size, int& Ascender, int& lineHeight)
+{
+	Ascender = 0;
+	lineHeight = 0;
+	if (!myRasterizer.setSize(Size))
+		return false;
+
+	const FT_Size_Metrics& Metrics = myRasterizer.Face->size->metrics;
+	Ascender = static_cast<int>((Metrics.ascender + 63) >> 6);
+	lineHeight = static_cast<int>((Metrics.height + 63) >> 6);
+	return true;
+}
+
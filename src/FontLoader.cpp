@@ -0,0 +1,87 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#include <sfttf/FontLoader.hpp>
+#include <sfttf/Atomic.hpp>
+#include <sfttf/FontFace.hpp>
+
+sfttf::FontLoader::FontLoader(FontManager* Manager, const FontManager::FaceKey& Key, FontManager::FileMap::iterator File) : myManager(Manager),
+																															myKey(Key),
+																															myFile(File),
+																															myMapping(0),
+																															myStarted(false),
+																															myFace(0),
+																															myDone(0)
+{
+	if (Manager->myFiles.end() == myFile)
+	{
+		myDone = 1;
+		return;
+	}
+	myMapping = &myFile->second->File;
+	myStarted = true;
+	Launch();
+}
+
+sfttf::FontLoader::~FontLoader()
+{
+	Wait();
+	delete myFace;
+}
+
+bool sfttf::FontLoader::isDone() const
+{
+	return 0 != atomicLoad(myDone);
+}
+
+void sfttf::FontLoader::Wait()
+{
+	if (myStarted)
+		sf::Thread::Wait();
+}
+
+/*
+	Hashing the file (see FontFace::getFontHash) reads every page of it,
+	which is most of the work for large fonts, and saves loadCache from
+	reading it again on the drawing thread.
+*/
+void sfttf::FontLoader::Run()
+{
+	FT_Library Library = 0;
+	if (0 == FT_Init_FreeType(&Library))
+	{
+		FontFace* newFace = new FontFace(myManager, Library, true);
+		if (newFace->Initialize(*myMapping, myKey.second))
+		{
+			newFace->getFontHash();
+			myFace = newFace;
+		}
+		else
+			delete newFace;
+	}
+	atomicStore(myDone, 1L);
+}
@@ -1,108 +1,528 @@
-/**********************************************************************
-Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
-All rights reserved.
-
-Redistribution and use in source and binary forms, with or without
-modification, are permitted provided that the following conditions
-are met:
-
-* Redistributions of source code must retain the above copyright
-notice, this list of conditions and the following disclaimer.
-
-* Redistributions in binary form must reproduce the above copyright
-notice, this list of conditions and the following disclaimer in the
-documentation and/or other materials provided with the distribution.
-
-THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
-"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
-LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
-A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
-OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
-SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
-LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
-DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
-THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
-(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
-OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-**********************************************************************/
-#include <sfttf/FontManager.hpp>
-#include <sfttf/Font.hpp>
-#include <cassert>
-
-sfttf::FontManager::FontManager() : myWindow(0),
-									myFreeType(0)
-{
-
-}
-
-
-sfttf::FontManager::~FontManager()
-{
-	Deinitialize();
-}
-
-bool sfttf::FontManager::Initialize(sf::RenderWindow* Window)
-{
-	Deinitialize();
-	if (0 != FT_Init_FreeType(&myFreeType))
-		return false;
-
-	myWindow = Window;
-	return true;
-}
-
-/*
-	Deinitialize does two things:
-	-Unload fonts
-	-Unload FreeType
-*/
-bool sfttf::FontManager::Deinitialize()
-{
-	unloadFonts();
-	myWindow = 0;
-
-	FT_Library Library = myFreeType;
-	myFreeType = 0;
-	if (0 != Library)
-	{
-		if (0 != FT_Done_FreeType(Library))
-			return false;
-	}
-	return true;
-}
-
-sfttf::Font* sfttf::FontManager::loadFont(const std::string& Filename)
-{
-	sfttf::Font* newFont = new sfttf::Font(myWindow, myFreeType);
-	if (!newFont->Initialize(Filename))
-	{
-		delete newFont;
-		return 0;
-	}
-	myFonts.push_back(newFont);
-	return newFont;
-}
-
-/*
-	Note about unloading fonts:
-	We do not need to call sfttf::Font::Deinitialize explicitly,
-	the font destructor already calls it.
-*/
-void sfttf::FontManager::unloadFont(sfttf::Font* Font)
-{
-	FontList::iterator itFont(std::find(myFonts.begin(), myFonts.end(), Font));
-	if (myFonts.end() != itFont)
-	{
-		myFonts.erase(itFont);
-		delete Font;
-	}
-}
-
-void sfttf::FontManager::unloadFonts()
-{
-	while (!myFonts.empty())
-	{
-		delete myFonts.back();
-		myFonts.pop_back();
-	}
-}
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#include <sfttf/FontManager.hpp>
+#include <sfttf/DistanceFieldProgram.hpp>
+#include <sfttf/Font.hpp>
+#include <sfttf/FontFace.hpp>
+#include <sfttf/FontLoader.hpp>
+#include <sfttf/Glyph.hpp>
+#include <algorithm>
+#include <cassert>
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Sleep.hpp>
+
+sfttf::FontManager::FontManager() : myWindow(0),
+									myFreeType(0),
+									myCacheBudget(0),
+									myUseStamp(0),
+									myThreadSafe(false)
+{
+
+}
+
+
+sfttf::FontManager::~FontManager()
+{
+	Deinitialize();
+}
+
+bool sfttf::FontManager::Initialize(sf::RenderWindow* Window)
+{
+	Deinitialize();
+	if (0 != FT_Init_FreeType(&myFreeType))
+		return false;
+
+	myWindow = Window;
+	return true;
+}
+
+/*
+	Deinitialize does two things:
+	-Unload fonts
+	-Unload FreeType
+*/
+bool sfttf::FontManager::Deinitialize()
+{
+	unloadFonts();
+	myWindow = 0;
+
+	FT_Library Library = myFreeType;
+	myFreeType = 0;
+	if (0 != Library)
+	{
+		if (0 != FT_Done_FreeType(Library))
+			return false;
+	}
+	return true;
+}
+
+sfttf::Font* sfttf::FontManager::loadFont(const std::string& Filename, long faceIndex)
+{
+	UseLock Lock(*this);
+	return openFont(Filename, faceIndex);
+}
+
+/*
+	Only the mapping is made here, which does not read the file,
+	the loader's thread does the rest.
+*/
+sfttf::FontLoader* sfttf::FontManager::loadFontAsync(const std::string& Filename, long faceIndex)
+{
+	UseLock Lock(*this);
+	const FaceKey Key(Filename, faceIndex);
+	FileMap::iterator itFile(myFiles.end());
+	if (myFaces.end() == myFaces.find(Key))
+	{
+		itFile = openFile(Filename);
+		if (myFiles.end() == itFile)
+			return 0;
+	}
+
+	sfttf::FontLoader* newLoader = new sfttf::FontLoader(this, Key, itFile);
+	newLoader->myHandle = myLoaders.insert(myLoaders.end(), newLoader);
+	return newLoader;
+}
+
+/*
+	The face may have been loaded meanwhile, by loadFont or another
+	loader: the loaded one is then dropped and the existing one shared.
+	If the loader did not start, the face was loaded already but may
+	have been unloaded since, so it is loaded the usual way.
+*/
+sfttf::Font* sfttf::FontManager::finishLoad(sfttf::FontLoader* Loader)
+{
+	if (0 == Loader || this != Loader->myManager)
+		return 0;
+
+	UseLock Lock(*this);
+	Loader->Wait();
+	sfttf::FontFace* loadedFace = Loader->myFace;
+	Loader->myFace = 0;
+	const FaceKey Key(Loader->myKey);
+	const FileMap::iterator itFile(Loader->myFile);
+	const bool Started = Loader->myStarted;
+	myLoaders.erase(Loader->myHandle);
+	delete Loader;
+
+	if (!Started)
+		return openFont(Key.first, Key.second);
+
+	FaceMap::iterator itFace(myFaces.find(Key));
+	if (myFaces.end() != itFace || 0 == loadedFace)
+	{
+		delete loadedFace;
+		closeFile(itFile);
+		if (myFaces.end() == itFace)
+			return 0;
+	}
+	else
+	{
+		itFace = myFaces.insert(std::make_pair(Key, loadedFace)).first;
+		loadedFace->myEntry = itFace;
+		loadedFace->myFile = itFile;
+	}
+	return addFont(itFace->second);
+}
+
+/*
+	Note about unloading fonts:
+	We do not need to call sfttf::FontFace::Deinitialize explicitly,
+	the font face destructor already calls it.
+
+	The font is looked up in myFonts before it is used, so pointers
+	already unloaded or from another manager are ignored. Its face
+	knows where it is in myFaces.
+*/
+void sfttf::FontManager::unloadFont(sfttf::Font* Font)
+{
+	UseLock Lock(*this);
+
+	FontList::iterator itFont(std::find(myFonts.begin(), myFonts.end(), Font));
+	if (myFonts.end() == itFont)
+		return;
+
+	sfttf::FontFace* Face = Font->myFontFace;
+	myFonts.erase(itFont);
+	delete Font;
+
+	if (0 == --Face->myReferences)
+	{
+		const FileMap::iterator itFile(Face->myFile);
+		myFaces.erase(Face->myEntry);
+		myWorkers.removeFace(Face);
+		delete Face;
+		closeFile(itFile);
+	}
+}
+
+void sfttf::FontManager::unloadFonts()
+{
+	UseLock Lock(*this);
+	while (!myLoaders.empty())
+	{
+		delete myLoaders.back();
+		myLoaders.pop_back();
+	}
+	while (!myFonts.empty())
+	{
+		delete myFonts.back();
+		myFonts.pop_back();
+	}
+	FaceMap::iterator itFace(myFaces.begin());
+	const FaceMap::iterator itEnd(myFaces.end());
+	for (; itEnd != itFace; ++itFace)
+	{
+		myWorkers.removeFace(itFace->second);
+		delete itFace->second;
+	}
+	myFaces.clear();
+
+	FileMap::iterator itFile(myFiles.begin());
+	const FileMap::iterator itFilesEnd(myFiles.end());
+	for (; itFilesEnd != itFile; ++itFile)
+		delete itFile->second;
+
+	myFiles.clear();
+}
+
+void sfttf::FontManager::setCacheBudget(std::size_t Bytes)
+{
+	UseLock Lock(*this);
+	myCacheBudget = Bytes;
+	if (0 != myCacheBudget)
+		trimCaches();
+}
+
+std::size_t sfttf::FontManager::getCacheBudget() const
+{
+	return myCacheBudget;
+}
+
+std::size_t sfttf::FontManager::getCacheSize() const
+{
+	UseLock Lock(*this);
+	return getTotalCacheSize();
+}
+
+/*
+	getCacheSize without the lock, for calls that already hold it.
+*/
+std::size_t sfttf::FontManager::getTotalCacheSize() const
+{
+	std::size_t Size = 0;
+	FaceMap::const_iterator itFace(myFaces.begin());
+	const FaceMap::const_iterator itEnd(myFaces.end());
+	for (; itEnd != itFace; ++itFace)
+		Size += itFace->second->getCacheSize();
+
+	return Size;
+}
+
+void sfttf::FontManager::setWorkerCount(unsigned int Count)
+{
+	UseLock Lock(*this);
+	myWorkers.setCount(Count);
+}
+
+unsigned int sfttf::FontManager::getWorkerCount() const
+{
+	return myWorkers.getCount();
+}
+
+/*
+	Every glyph is queued for the workers before any is waited for,
+	then they are collected as they arrive. A job is finished once none
+	of its glyphs is pending: those the workers failed to render, or
+	that were evicted meanwhile, are then rendered here.
+
+	The lock is only held to queue and collect, other threads can draw
+	while the workers render.
+	Workers added for the call are stopped at the end, unless the
+	worker count was changed meanwhile.
+*/
+bool sfttf::FontManager::prewarmCaches(PrewarmJobList& Jobs, unsigned int Threads)
+{
+	if (0 == Threads)
+		Threads = GlyphWorkers::getProcessorCount();
+
+	const sf::Clock Clock;
+	std::vector<std::vector<GlyphKey> > jobKeys(Jobs.size());
+	std::vector<std::size_t> nextKey(Jobs.size(), 0);
+	std::vector<bool> Finished(Jobs.size(), false);
+	unsigned int oldCount = 0;
+	{
+		UseLock Lock(*this);
+		oldCount = myWorkers.getCount();
+		if (Threads > oldCount)
+			myWorkers.setCount(Threads);
+
+		for (std::size_t i = 0; i < Jobs.size(); ++i)
+		{
+			Jobs[i].Success = queuePrewarm(Jobs[i], jobKeys[i]);
+			Jobs[i].Seconds = 0.0f;
+		}
+	}
+
+	std::size_t Remaining = Jobs.size();
+	while (0 != Remaining)
+	{
+		{
+			UseLock Lock(*this);
+			for (std::size_t i = 0; i < Jobs.size(); ++i)
+			{
+				if (Finished[i])
+					continue;
+
+				const std::vector<GlyphKey>& Keys = jobKeys[i];
+				if (!Keys.empty())
+				{
+					sfttf::FontFace* Face = Jobs[i].Font->myFontFace;
+					Face->collectGlyphs();
+					while (nextKey[i] < Keys.size() && !Face->isPending(Keys[nextKey[i]]))
+						++nextKey[i];
+
+					if (nextKey[i] < Keys.size())
+						continue;
+
+					Face->beginUse();
+					for (std::size_t k = 0; k < Keys.size(); ++k)
+					{
+						bool Pending = false;
+						if (0 == Face->cacheGlyph(Keys[k], false, Pending))
+							Jobs[i].Success = false;
+					}
+				}
+				Jobs[i].Seconds = Clock.GetElapsedTime();
+				Finished[i] = true;
+				--Remaining;
+			}
+		}
+		if (0 != Remaining)
+			sf::Sleep(0.001f);
+	}
+
+	{
+		UseLock Lock(*this);
+		if (Threads > oldCount && Threads == myWorkers.getCount())
+			myWorkers.setCount(oldCount);
+	}
+
+	bool Result = true;
+	for (std::size_t i = 0; i < Jobs.size(); ++i)
+	{
+		if (!Jobs[i].Success)
+			Result = false;
+	}
+	return Result;
+}
+
+/*
+	Combined and distance field glyphs depend on what OpenGL supports,
+	which is checked the first time they are used. This needs the
+	window's context, so it is done here rather than on another thread.
+*/
+void sfttf::FontManager::setThreadSafe(bool ThreadSafe)
+{
+	if (ThreadSafe)
+	{
+		GlyphBatch::isCombineSupported();
+		DistanceFieldProgram::getProgram();
+	}
+	myThreadSafe = ThreadSafe;
+}
+
+bool sfttf::FontManager::isThreadSafe() const
+{
+	return myThreadSafe;
+}
+
+sfttf::FontManager::UseLock::UseLock(const FontManager& Manager) : myMutex(Manager.myThreadSafe ? &Manager.myMutex : 0)
+{
+	if (0 != myMutex)
+		myMutex->Lock();
+}
+
+sfttf::FontManager::UseLock::~UseLock()
+{
+	if (0 != myMutex)
+		myMutex->Unlock();
+}
+
+/*
+	Maps Filename, or adds a reference to it if it is already mapped.
+	Returns myFiles.end() if it cannot be mapped.
+*/
+sfttf::FontManager::FileMap::iterator sfttf::FontManager::openFile(const std::string& Filename)
+{
+	FileMap::iterator itFile(myFiles.find(Filename));
+	if (myFiles.end() == itFile)
+	{
+		SharedFile* newFile = new SharedFile;
+		if (!newFile->File.Open(Filename))
+		{
+			delete newFile;
+			return myFiles.end();
+		}
+		itFile = myFiles.insert(std::make_pair(Filename, newFile)).first;
+	}
+	++itFile->second->References;
+	return itFile;
+}
+
+/*
+	Unmaps the file once no face uses it.
+*/
+void sfttf::FontManager::closeFile(FileMap::iterator itFile)
+{
+	if (0 != --itFile->second->References)
+		return;
+
+	delete itFile->second;
+	myFiles.erase(itFile);
+}
+
+sfttf::Font* sfttf::FontManager::openFont(const std::string& Filename, long faceIndex)
+{
+	const FaceKey Key(Filename, faceIndex);
+	FaceMap::iterator itFace(myFaces.find(Key));
+	if (myFaces.end() == itFace)
+	{
+		const FileMap::iterator itFile(openFile(Filename));
+		if (myFiles.end() == itFile)
+			return 0;
+
+		sfttf::FontFace* newFace = new sfttf::FontFace(this, myFreeType);
+		if (!newFace->Initialize(itFile->second->File, faceIndex))
+		{
+			delete newFace;
+			closeFile(itFile);
+			return 0;
+		}
+		itFace = myFaces.insert(std::make_pair(Key, newFace)).first;
+		newFace->myEntry = itFace;
+		newFace->myFile = itFile;
+	}
+	return addFont(itFace->second);
+}
+
+/*
+	Adds a handle to Face.
+*/
+sfttf::Font* sfttf::FontManager::addFont(sfttf::FontFace* Face)
+{
+	++Face->myReferences;
+
+	sfttf::Font* newFont = new sfttf::Font(this, myWindow, Face);
+	myFonts.push_back(newFont);
+	return newFont;
+}
+
+/*
+	Evicts the least recently used glyph of all font faces until the
+	total is within myCacheBudget.
+	Ages are compared as differences from myUseStamp, so this keeps
+	working when the counter wraps around.
+*/
+void sfttf::FontManager::trimCaches()
+{
+	std::size_t Size = getTotalCacheSize();
+	while (Size > myCacheBudget)
+	{
+		sfttf::FontFace* oldestFace = 0;
+		unsigned int oldestAge = 0;
+		FaceMap::iterator itFace(myFaces.begin());
+		const FaceMap::iterator itEnd(myFaces.end());
+		for (; itEnd != itFace; ++itFace)
+		{
+			const sfttf::Glyph* g = itFace->second->getLeastRecentlyUsed();
+			if (!g)
+				continue;
+
+			const unsigned int Age = myUseStamp - g->lastUsed;
+			if (!oldestFace || Age > oldestAge)
+			{
+				oldestFace = itFace->second;
+				oldestAge = Age;
+			}
+		}
+		if (!oldestFace)
+			break;
+
+		const std::size_t faceSize = oldestFace->getCacheSize();
+		oldestFace->evictGlyph(oldestFace->getLeastRecentlyUsed());
+		Size -= faceSize - oldestFace->getCacheSize();
+	}
+}
+
+/*
+	Lists the glyphs of Job in Keys, setting the font's size and outline
+	the way drawing would, and queues those not cached for the workers.
+	Returns false if the job has glyphs that cannot be rendered
+	(size 0, or a font from another manager).
+*/
+bool sfttf::FontManager::queuePrewarm(const PrewarmJob& Job, std::vector<GlyphKey>& Keys)
+{
+	if (0 == Job.Font || this != Job.Font->myManager)
+		return false;
+
+	sfttf::Font& theFont = *Job.Font;
+	const Font::Settings savedSettings(theFont.mySettings);
+	bool Result = true;
+	for (std::size_t s = 0; s < Job.Sizes.size(); ++s)
+	{
+		theFont.mySettings.Size = Job.Sizes[s];
+		for (std::size_t o = 0; o <= Job.outlineSizes.size(); ++o)
+		{
+			/*
+				The first pass is without outline.
+			*/
+			theFont.mySettings.Outline = (0 != o);
+			if (0 != o)
+				theFont.mySettings.outlineSize = Job.outlineSizes[o - 1];
+
+			for (std::size_t c = 0; c < Job.Text.size(); ++c)
+			{
+				if (!theFont.addPhaseKeys(static_cast<uint32_t>(Job.Text[c]), Keys))
+					Result = false;
+			}
+		}
+	}
+	theFont.mySettings = savedSettings;
+
+	std::sort(Keys.begin(), Keys.end());
+	Keys.erase(std::unique(Keys.begin(), Keys.end()), Keys.end());
+
+	sfttf::FontFace* Face = theFont.myFontFace;
+	Face->beginUse();
+	for (std::size_t k = 0; k < Keys.size(); ++k)
+	{
+		bool Pending = false;
+		Face->cacheGlyph(Keys[k], true, Pending);
+	}
+	return Result;
+}
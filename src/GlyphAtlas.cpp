@@ -0,0 +1,608 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#include <sfttf/GlyphAtlas.hpp>
+#include <algorithm>
+#include <cstring>
+#include <SFML/Window/OpenGL.hpp>
+
+/*
+	SSE2 row conversion, where the compiler has the intrinsics.
+	64-bit x86 always has SSE2, 32-bit x86 is checked at run time (see GlyphAtlas::getRowConverter).
+*/
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define SFTTF_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace
+{
+	/*
+		Default page dimensions.
+		Glyphs larger than this get a page of their own.
+	*/
+	const unsigned int pageSize = 512;
+
+	/*
+		Empty pixels left between glyphs so smoothing does not bleed
+		neighbouring glyphs into each other.
+	*/
+	const unsigned int glyphPadding = 1;
+
+	unsigned int nextPowerOfTwo(unsigned int Value)
+	{
+		unsigned int Result = 1;
+		while (Result < Value)
+			Result <<= 1;
+
+		return Result;
+	}
+
+	void convertRow(const unsigned char* Coverage, const unsigned char* outlineShare, sf::Uint8* Destination, unsigned int Width)
+	{
+		for (unsigned int x = 0; x < Width; ++x)
+		{
+			Destination[0] = outlineShare[x];
+			Destination[1] = Coverage[x];
+			Destination += 2;
+		}
+	}
+
+#ifdef SFTTF_SSE2
+	/*
+		16 pixels at a time, interleaving the share and coverage bytes.
+	*/
+	void convertRowSse2(const unsigned char* Coverage, const unsigned char* outlineShare, sf::Uint8* Destination, unsigned int Width)
+	{
+		unsigned int x = 0;
+		for (; x + 16 <= Width; x += 16)
+		{
+			const __m128i Alpha = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Coverage + x));
+			const __m128i Share = _mm_loadu_si128(reinterpret_cast<const __m128i*>(outlineShare + x));
+			__m128i* pDestination = reinterpret_cast<__m128i*>(Destination + x * 2);
+			_mm_storeu_si128(pDestination, _mm_unpacklo_epi8(Share, Alpha));
+			_mm_storeu_si128(pDestination + 1, _mm_unpackhi_epi8(Share, Alpha));
+		}
+		convertRow(Coverage + x, outlineShare + x, Destination + x * 2, Width - x);
+	}
+
+	bool isSse2Supported()
+	{
+#if defined(_M_IX86)
+		int Info[4];
+		__cpuid(Info, 1);
+		return 0 != (Info[3] & (1 << 26));
+#else
+		return true;
+#endif
+	}
+#endif
+
+	/*
+		Turns one row of a mono or LCD bitmap into 8-bit coverage.
+		LCD samples are averaged, the atlas has one coverage value per pixel.
+		Row points at the first (of three for vertical LCD) sample rows.
+	*/
+	void unpackRow(const FT_Bitmap& Bitmap, const unsigned char* Row, unsigned char* Coverage, unsigned int Width)
+	{
+		switch (Bitmap.pixel_mode)
+		{
+		case FT_PIXEL_MODE_MONO:
+			for (unsigned int x = 0; x < Width; ++x)
+				Coverage[x] = static_cast<unsigned char>(0 - ((Row[x >> 3] >> (7 - (x & 7))) & 1));
+
+			break;
+		case FT_PIXEL_MODE_LCD:
+			for (unsigned int x = 0; x < Width; ++x)
+				Coverage[x] = static_cast<unsigned char>((Row[3 * x] + Row[3 * x + 1] + Row[3 * x + 2]) / 3);
+
+			break;
+		case FT_PIXEL_MODE_LCD_V:
+		{
+			const unsigned char* Second = Row + Bitmap.pitch;
+			const unsigned char* Third = Second + Bitmap.pitch;
+			for (unsigned int x = 0; x < Width; ++x)
+				Coverage[x] = static_cast<unsigned char>((Row[x] + Second[x] + Third[x]) / 3);
+
+			break;
+		}
+		default:
+			std::fill(Coverage, Coverage + Width, static_cast<unsigned char>(0));
+			break;
+		}
+	}
+}
+
+sfttf::GlyphAtlas::GlyphAtlas()
+{
+}
+
+sfttf::GlyphAtlas::RowConverter sfttf::GlyphAtlas::getRowConverter(bool Vectorized)
+{
+#ifdef SFTTF_SSE2
+	if (Vectorized && isSse2Supported())
+		return &convertRowSse2;
+#endif
+	return &convertRow;
+}
+
+sfttf::GlyphAtlas::~GlyphAtlas()
+{
+	Clear();
+}
+
+bool sfttf::GlyphAtlas::Allocate(unsigned int Width, unsigned int Height, bool Combined, unsigned int& Page, sf::IntRect& Rect)
+{
+	if (0 == Width || 0 == Height)
+		return false;
+
+	for (unsigned int i = 0; i < myPages.size(); ++i)
+	{
+		if (myPages[i]->Combined == Combined && allocateFreeRect(myPages[i], Width, Height, Rect))
+		{
+			Page = i;
+			return true;
+		}
+	}
+	for (unsigned int i = 0; i < myPages.size(); ++i)
+	{
+		if (myPages[i]->Combined == Combined && !myPages[i]->Pixels.empty() && allocateOnPage(myPages[i], Width, Height, Rect))
+		{
+			Page = i;
+			return true;
+		}
+	}
+
+	/*
+		Page dimensions are kept a power of two so the texture is never
+		padded by SFML and texture coordinates stay simple.
+		A released page of those dimensions is used again before a new
+		one is created.
+	*/
+	const unsigned int pageWidth = std::max(pageSize, nextPowerOfTwo(Width + glyphPadding));
+	const unsigned int pageHeight = std::max(pageSize, nextPowerOfTwo(Height + glyphPadding));
+	for (unsigned int i = 0; i < myPages.size(); ++i)
+	{
+		sfttf::GlyphAtlas::Page* thePage = myPages[i];
+		if (thePage->Combined == Combined && thePage->Pixels.empty() && thePage->Width == pageWidth && thePage->Height == pageHeight)
+		{
+			clearPixels(thePage);
+			if (!allocateOnPage(thePage, Width, Height, Rect))
+				return false;
+
+			Page = i;
+			return true;
+		}
+	}
+	sfttf::GlyphAtlas::Page* newPage = createPage(pageWidth, pageHeight, Combined);
+	if (!allocateOnPage(newPage, Width, Height, Rect))
+		return false;
+
+	Page = static_cast<unsigned int>(myPages.size() - 1);
+	return true;
+}
+
+/*
+	Coverage is copied as is, or interleaved with outlineShare on combined pages.
+	Rows other than 8-bit gray are unpacked into a row of coverage first.
+*/
+void sfttf::GlyphAtlas::Upload(unsigned int Page, const sf::IntRect& Rect, const FT_Bitmap& Bitmap, const unsigned char* outlineShare)
+{
+	static const RowConverter Convert = getRowConverter();
+
+	sfttf::GlyphAtlas::Page* thePage = myPages[Page];
+	const unsigned int Width = std::min<unsigned int>(getBitmapWidth(Bitmap), Rect.GetWidth());
+	const unsigned int Height = std::min<unsigned int>(getBitmapHeight(Bitmap), Rect.GetHeight());
+
+	/*
+		Bitmap.pitch is in bytes and may be negative (bottom-up bitmaps).
+		Vertical LCD bitmaps have three sample rows per pixel.
+	*/
+	const unsigned char* pSource = Bitmap.buffer;
+	if (Bitmap.pitch < 0)
+		pSource -= Bitmap.pitch * (static_cast<int>(Bitmap.rows) - 1);
+
+	const int rowPitch = (FT_PIXEL_MODE_LCD_V == Bitmap.pixel_mode) ? 3 * Bitmap.pitch : Bitmap.pitch;
+	const bool Unpack = (FT_PIXEL_MODE_GRAY != Bitmap.pixel_mode);
+	std::vector<unsigned char> Row(Unpack ? Width : 0);
+	for (unsigned int y = 0; y < Height; ++y)
+	{
+		const unsigned char* Coverage = pSource;
+		if (Unpack)
+		{
+			unpackRow(Bitmap, pSource, &Row[0], Width);
+			Coverage = &Row[0];
+		}
+		sf::Uint8* pDestination = &thePage->Pixels[((Rect.Top + y) * thePage->Width + Rect.Left) * getBytesPerPixel(thePage)];
+		if (thePage->Combined)
+			Convert(Coverage, outlineShare + y * Bitmap.width, pDestination, Width);
+		else
+			std::memcpy(pDestination, Coverage, Width);
+
+		pSource += rowPitch;
+	}
+	thePage->Dirty = true;
+}
+
+void sfttf::GlyphAtlas::Download(unsigned int Page, const sf::IntRect& Rect, unsigned char* Coverage, unsigned char* outlineShare) const
+{
+	const sfttf::GlyphAtlas::Page* thePage = myPages[Page];
+	const unsigned int bytesPerPixel = getBytesPerPixel(thePage);
+	for (int y = Rect.Top; y < Rect.Bottom; ++y)
+	{
+		const sf::Uint8* pSource = &thePage->Pixels[(y * thePage->Width + Rect.Left) * bytesPerPixel];
+		for (int x = Rect.Left; x < Rect.Right; ++x)
+		{
+			*Coverage++ = pSource[bytesPerPixel - 1];
+			if (outlineShare)
+				*outlineShare++ = thePage->Combined ? pSource[0] : 0xff;
+
+			pSource += bytesPerPixel;
+		}
+	}
+}
+
+/*
+	The area is cleared so smoothing never picks up what was there before.
+*/
+void sfttf::GlyphAtlas::Free(unsigned int Page, const sf::IntRect& Rect)
+{
+	sfttf::GlyphAtlas::Page* thePage = myPages[Page];
+	if (0 == --thePage->glyphCount)
+	{
+		releasePage(thePage);
+		return;
+	}
+
+	const sf::IntRect Slot(Rect.Left,
+		Rect.Top,
+		std::min<int>(Rect.Right + glyphPadding, thePage->Width),
+		std::min<int>(Rect.Bottom + glyphPadding, thePage->Height));
+
+	const unsigned int bytesPerPixel = getBytesPerPixel(thePage);
+	for (int y = Slot.Top; y < Slot.Bottom; ++y)
+	{
+		sf::Uint8* pDestination = &thePage->Pixels[(y * thePage->Width + Slot.Left) * bytesPerPixel];
+		for (int x = Slot.Left; x < Slot.Right; ++x)
+		{
+			pDestination[bytesPerPixel - 1] = 0;
+			pDestination += bytesPerPixel;
+		}
+	}
+	thePage->Dirty = true;
+	addFreeRect(thePage, Slot);
+}
+
+/*
+	Alpha textures take their color from the vertices (GL_MODULATE),
+	luminance/alpha textures give GlyphBatch the outline share as their color.
+	Rows are at least pageSize bytes and a power of two, so the default
+	unpack alignment of 4 is fine.
+*/
+void sfttf::GlyphAtlas::Bind(unsigned int Page)
+{
+	sfttf::GlyphAtlas::Page* thePage = myPages[Page];
+	const GLenum Format = thePage->Combined ? GL_LUMINANCE_ALPHA : GL_ALPHA;
+	glEnable(GL_TEXTURE_2D);
+	if (thePage->Pixels.empty())
+	{
+		glBindTexture(GL_TEXTURE_2D, 0);
+		return;
+	}
+	if (0 == thePage->Texture)
+	{
+		GLuint Texture = 0;
+		glGenTextures(1, &Texture);
+		glBindTexture(GL_TEXTURE_2D, Texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexImage2D(GL_TEXTURE_2D, 0, Format, thePage->Width, thePage->Height, 0, Format, GL_UNSIGNED_BYTE, &thePage->Pixels[0]);
+		thePage->Texture = Texture;
+		thePage->Dirty = false;
+		return;
+	}
+	glBindTexture(GL_TEXTURE_2D, thePage->Texture);
+	if (thePage->Dirty)
+	{
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, thePage->Width, thePage->Height, Format, GL_UNSIGNED_BYTE, &thePage->Pixels[0]);
+		thePage->Dirty = false;
+	}
+}
+
+unsigned int sfttf::GlyphAtlas::getPageWidth(unsigned int Page) const
+{
+	return myPages[Page]->Width;
+}
+
+unsigned int sfttf::GlyphAtlas::getPageHeight(unsigned int Page) const
+{
+	return myPages[Page]->Height;
+}
+
+void sfttf::GlyphAtlas::Clear()
+{
+	while (!myPages.empty())
+	{
+		if (0 != myPages.back()->Texture)
+		{
+			const GLuint Texture = myPages.back()->Texture;
+			glDeleteTextures(1, &Texture);
+		}
+		delete myPages.back();
+		myPages.pop_back();
+	}
+}
+
+unsigned int sfttf::GlyphAtlas::getPageCount() const
+{
+	return static_cast<unsigned int>(myPages.size());
+}
+
+/*
+	Pages are allocated whole, and the same size again in texture memory.
+	Released pages take nothing.
+*/
+std::size_t sfttf::GlyphAtlas::getMemory() const
+{
+	std::size_t Bytes = 0;
+	for (unsigned int i = 0; i < myPages.size(); ++i)
+		Bytes += myPages[i]->Pixels.size();
+
+	return Bytes;
+}
+
+unsigned int sfttf::GlyphAtlas::getBitmapWidth(const FT_Bitmap& Bitmap)
+{
+	if (FT_PIXEL_MODE_LCD == Bitmap.pixel_mode)
+		return Bitmap.width / 3;
+
+	return Bitmap.width;
+}
+
+unsigned int sfttf::GlyphAtlas::getBitmapHeight(const FT_Bitmap& Bitmap)
+{
+	if (FT_PIXEL_MODE_LCD_V == Bitmap.pixel_mode)
+		return Bitmap.rows / 3;
+
+	return Bitmap.rows;
+}
+
+sfttf::GlyphAtlas::Page* sfttf::GlyphAtlas::createPage(unsigned int Width, unsigned int Height, bool Combined)
+{
+	sfttf::GlyphAtlas::Page* newPage = new sfttf::GlyphAtlas::Page;
+	newPage->Width = Width;
+	newPage->Height = Height;
+	newPage->shelfBottom = 0;
+	newPage->glyphCount = 0;
+	newPage->Combined = Combined;
+	newPage->Texture = 0;
+	clearPixels(newPage);
+	myPages.push_back(newPage);
+	return newPage;
+}
+
+/*
+	Unused pixels are transparent.
+	On combined pages they are all outline, like the edges of
+	combined glyphs, so smoothing does not fade to the fill color.
+*/
+void sfttf::GlyphAtlas::clearPixels(Page* thePage)
+{
+	thePage->Pixels.resize(thePage->Width * thePage->Height * getBytesPerPixel(thePage), 0);
+	if (thePage->Combined)
+	{
+		for (unsigned int i = 0; i < thePage->Pixels.size(); i += 2)
+			thePage->Pixels[i] = 0xff;
+	}
+	thePage->Dirty = true;
+}
+
+/*
+	Frees the pixels and texture of a page without glyphs,
+	keeping its place in myPages (glyphs refer to pages by index).
+*/
+void sfttf::GlyphAtlas::releasePage(Page* thePage)
+{
+	if (0 != thePage->Texture)
+	{
+		const GLuint Texture = thePage->Texture;
+		glDeleteTextures(1, &Texture);
+		thePage->Texture = 0;
+	}
+	std::vector<sf::Uint8>().swap(thePage->Pixels);
+	thePage->Shelves.clear();
+	thePage->freeRects.clear();
+	thePage->shelfBottom = 0;
+	thePage->Dirty = false;
+}
+
+unsigned int sfttf::GlyphAtlas::getBytesPerPixel(const Page* thePage)
+{
+	return thePage->Combined ? 2 : 1;
+}
+
+/*
+	Merges Rect with free areas sharing a whole edge with it, then adds it.
+	A merge may make another one possible, so the search starts over.
+*/
+void sfttf::GlyphAtlas::addFreeRect(Page* thePage, sf::IntRect Rect)
+{
+	std::vector<sf::IntRect>& freeRects = thePage->freeRects;
+	std::size_t i = 0;
+	while (i < freeRects.size())
+	{
+		const sf::IntRect& Other = freeRects[i];
+		const bool sameColumn = (Other.Left == Rect.Left && Other.Right == Rect.Right && (Other.Bottom == Rect.Top || Other.Top == Rect.Bottom));
+		const bool sameRow = (Other.Top == Rect.Top && Other.Bottom == Rect.Bottom && (Other.Right == Rect.Left || Other.Left == Rect.Right));
+		if (!sameColumn && !sameRow)
+		{
+			++i;
+			continue;
+		}
+
+		Rect = sf::IntRect(std::min(Rect.Left, Other.Left),
+			std::min(Rect.Top, Other.Top),
+			std::max(Rect.Right, Other.Right),
+			std::max(Rect.Bottom, Other.Bottom));
+		freeRects[i] = freeRects.back();
+		freeRects.pop_back();
+		i = 0;
+	}
+
+	/*
+		A whole shelf left without glyphs is emptied instead, merged with
+		the empty shelves next to it, and taken off the page if it is the
+		last one, so taller glyphs can use the space again.
+	*/
+	ShelfList& Shelves = thePage->Shelves;
+	for (std::size_t j = 0; j < Shelves.size(); ++j)
+	{
+		Shelf& theShelf = Shelves[j];
+		if (0 != Rect.Left || static_cast<int>(theShelf.Width) != Rect.Right || static_cast<int>(theShelf.Y) != Rect.Top || static_cast<int>(theShelf.Y + theShelf.Height) != Rect.Bottom)
+			continue;
+
+		theShelf.Width = 0;
+		if (j + 1 < Shelves.size() && 0 == Shelves[j + 1].Width)
+		{
+			theShelf.Height += Shelves[j + 1].Height;
+			Shelves.erase(Shelves.begin() + j + 1);
+		}
+		if (j > 0 && 0 == Shelves[j - 1].Width)
+		{
+			Shelves[j - 1].Height += theShelf.Height;
+			Shelves.erase(Shelves.begin() + j);
+			--j;
+		}
+		if (j + 1 == Shelves.size())
+		{
+			thePage->shelfBottom = Shelves[j].Y;
+			Shelves.pop_back();
+		}
+		return;
+	}
+	freeRects.push_back(Rect);
+}
+
+/*
+	Smallest freed area the glyph (with padding) fits in.
+	The glyph takes its top left corner, the rest is split in two
+	along the side with more room left, and stays free.
+*/
+bool sfttf::GlyphAtlas::allocateFreeRect(Page* thePage, unsigned int Width, unsigned int Height, sf::IntRect& Rect)
+{
+	const int paddedWidth = Width + glyphPadding;
+	const int paddedHeight = Height + glyphPadding;
+
+	std::vector<sf::IntRect>::iterator itBest(thePage->freeRects.end());
+	std::vector<sf::IntRect>::iterator itRect(thePage->freeRects.begin());
+	const std::vector<sf::IntRect>::iterator itEnd(thePage->freeRects.end());
+	for (; itEnd != itRect; ++itRect)
+	{
+		if (itRect->GetWidth() < paddedWidth || itRect->GetHeight() < paddedHeight)
+			continue;
+
+		if (itEnd == itBest || itRect->GetWidth() * itRect->GetHeight() < itBest->GetWidth() * itBest->GetHeight())
+			itBest = itRect;
+	}
+	if (itEnd == itBest)
+		return false;
+
+	const sf::IntRect Best(*itBest);
+	*itBest = thePage->freeRects.back();
+	thePage->freeRects.pop_back();
+
+	Rect = sf::IntRect(Best.Left, Best.Top, Best.Left + Width, Best.Top + Height);
+	const int Right = Best.Left + paddedWidth;
+	const int Bottom = Best.Top + paddedHeight;
+	if (Best.Right - Right > Best.Bottom - Bottom)
+	{
+		if (Best.Bottom > Bottom)
+			addFreeRect(thePage, sf::IntRect(Best.Left, Bottom, Right, Best.Bottom));
+
+		addFreeRect(thePage, sf::IntRect(Right, Best.Top, Best.Right, Best.Bottom));
+	}
+	else
+	{
+		if (Best.Right > Right)
+			addFreeRect(thePage, sf::IntRect(Right, Best.Top, Best.Right, Bottom));
+
+		if (Best.Bottom > Bottom)
+			addFreeRect(thePage, sf::IntRect(Best.Left, Bottom, Best.Right, Best.Bottom));
+	}
+	++thePage->glyphCount;
+	return true;
+}
+
+/*
+	Best-fit shelf packing.
+	The shelf wasting the least height is used, unless it wastes more
+	than half the glyph height and a new shelf can still be opened.
+*/
+bool sfttf::GlyphAtlas::allocateOnPage(Page* thePage, unsigned int Width, unsigned int Height, sf::IntRect& Rect)
+{
+	const unsigned int paddedWidth = Width + glyphPadding;
+	const unsigned int paddedHeight = Height + glyphPadding;
+
+	Shelf* bestShelf = 0;
+	ShelfList::iterator itShelf(thePage->Shelves.begin());
+	const ShelfList::iterator itEnd(thePage->Shelves.end());
+	for (; itEnd != itShelf; ++itShelf)
+	{
+		if (itShelf->Height < paddedHeight || itShelf->Width + paddedWidth > thePage->Width)
+			continue;
+
+		if (!bestShelf || itShelf->Height < bestShelf->Height)
+			bestShelf = &*itShelf;
+	}
+
+	const bool canOpenShelf = thePage->shelfBottom + paddedHeight <= thePage->Height && paddedWidth <= thePage->Width;
+	if (canOpenShelf && (!bestShelf || bestShelf->Height - paddedHeight > paddedHeight / 2))
+	{
+		Shelf newShelf;
+		newShelf.Y = thePage->shelfBottom;
+		newShelf.Height = paddedHeight;
+		newShelf.Width = 0;
+		thePage->shelfBottom += paddedHeight;
+		thePage->Shelves.push_back(newShelf);
+		bestShelf = &thePage->Shelves.back();
+	}
+	if (!bestShelf)
+		return false;
+
+	Rect = sf::IntRect(bestShelf->Width, bestShelf->Y, bestShelf->Width + Width, bestShelf->Y + Height);
+	if (bestShelf->Height > paddedHeight)
+		addFreeRect(thePage, sf::IntRect(Rect.Left, Rect.Top + paddedHeight, Rect.Left + paddedWidth, bestShelf->Y + bestShelf->Height));
+
+	bestShelf->Width += paddedWidth;
+	++thePage->glyphCount;
+	return true;
+}
@@ -0,0 +1,380 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#include <sfttf/GlyphBatch.hpp>
+#include <sfttf/DistanceFieldProgram.hpp>
+#include <sfttf/GlyphAtlas.hpp>
+#include <sfttf/Glyph.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <SFML/Window/OpenGL.hpp>
+
+/*
+	OpenGL 1.3 texture combiners, which Windows' gl.h does not have.
+*/
+#ifndef GL_COMBINE
+#define GL_COMBINE			0x8570
+#define GL_COMBINE_RGB		0x8571
+#define GL_COMBINE_ALPHA	0x8572
+#define GL_INTERPOLATE		0x8575
+#define GL_CONSTANT			0x8576
+#define GL_PRIMARY_COLOR	0x8577
+#define GL_SOURCE0_RGB		0x8580
+#define GL_SOURCE1_RGB		0x8581
+#define GL_SOURCE2_RGB		0x8582
+#define GL_SOURCE0_ALPHA	0x8588
+#define GL_SOURCE1_ALPHA	0x8589
+#define GL_OPERAND0_RGB		0x8590
+#define GL_OPERAND1_RGB		0x8591
+#define GL_OPERAND2_RGB		0x8592
+#define GL_OPERAND0_ALPHA	0x8598
+#define GL_OPERAND1_ALPHA	0x8599
+#endif
+
+sfttf::GlyphBatch::GlyphBatch(GlyphAtlas& Atlas) : myAtlas(&Atlas),
+												  myCombinedCount(0),
+												  myDistanceFieldCount(0),
+												  myEmpty(true)
+{
+}
+
+void sfttf::GlyphBatch::Add(const Glyph& g, float X, float Y, const sf::Color& Color)
+{
+	addQuad(myVertices, g, X, Y, 1.0f, Color);
+}
+
+void sfttf::GlyphBatch::Add(const Glyph& g, float X, float Y, const sf::Color& Color, const sf::Color& outlineColor)
+{
+	if (0 == g.textureRect.GetWidth() || 0 == g.textureRect.GetHeight())
+		return;
+
+	addQuad(getGroup(myCombined, myCombinedCount, outlineColor, 0.0f), g, X, Y, 1.0f, Color);
+}
+
+void sfttf::GlyphBatch::Add(const Glyph& g, float X, float Y, float Scale, const sf::Color& Color, const sf::Color& outlineColor, float outlineWidth)
+{
+	if (0 == g.textureRect.GetWidth() || 0 == g.textureRect.GetHeight())
+		return;
+
+	addQuad(getGroup(myDistanceFields, myDistanceFieldCount, outlineColor, outlineWidth), g, X, Y, Scale, Color);
+}
+
+void sfttf::GlyphBatch::Clear()
+{
+	PageVertices::iterator itPage(myVertices.begin());
+	const PageVertices::iterator itEnd(myVertices.end());
+	for (; itEnd != itPage; ++itPage)
+		itPage->clear();
+
+	clearGroups(myCombined, myCombinedCount);
+	clearGroups(myDistanceFields, myDistanceFieldCount);
+	myEmpty = true;
+	myBounds = sf::FloatRect();
+}
+
+bool sfttf::GlyphBatch::isEmpty() const
+{
+	return myEmpty;
+}
+
+const sf::FloatRect& sfttf::GlyphBatch::getBounds() const
+{
+	return myBounds;
+}
+
+/*
+	Straight (not premultiplied) alpha, Porter-Duff 'over' like
+	the window's blending.
+*/
+void sfttf::GlyphBatch::Composite(sf::Uint8* Pixels, unsigned int Width, unsigned int Height, int OffsetX, int OffsetY) const
+{
+	compositePages(myVertices, 0, Pixels, Width, Height, OffsetX, OffsetY);
+	for (std::size_t Group = 0; Group < myCombinedCount; ++Group)
+		compositePages(myCombined[Group].Pages, &myCombined[Group].outlineColor, Pixels, Width, Height, OffsetX, OffsetY);
+}
+
+/*
+	The result is cached, contexts of one program all get the same driver.
+*/
+bool sfttf::GlyphBatch::isCombineSupported()
+{
+	static int Supported = -1;
+	if (-1 == Supported)
+	{
+		Supported = 0;
+		const char* Version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+		const char* Extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+		if (Version)
+		{
+			char* pMinor = 0;
+			const long Major = std::strtol(Version, &pMinor, 10);
+			const long Minor = ('.' == *pMinor) ? std::strtol(pMinor + 1, 0, 10) : 0;
+			if (Major > 1 || (1 == Major && Minor >= 3))
+				Supported = 1;
+		}
+		if (Extensions && std::strstr(Extensions, "GL_ARB_texture_env_combine"))
+			Supported = 1;
+	}
+	return 1 == Supported;
+}
+
+/*
+	Plain OpenGL 1.1 vertex arrays: one glDrawArrays per page.
+	Vertex colors replace the drawable color, which SFML has already set.
+
+	Combined glyphs use the texture combiner: the texture's color channels
+	(the outline share) interpolate between the outline color (the
+	constant) and the fill color (the vertex color), alpha is modulated
+	as usual.
+	Distance field glyphs are drawn with DistanceFieldProgram.
+*/
+void sfttf::GlyphBatch::Render(sf::RenderTarget&) const
+{
+	if (myEmpty)
+		return;
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	drawPages(myVertices);
+	if (0 != myCombinedCount)
+	{
+		glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_COMBINE);
+		glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_RGB, GL_INTERPOLATE);
+		glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE0_RGB, GL_CONSTANT);
+		glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND0_RGB, GL_SRC_COLOR);
+		glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE1_RGB, GL_PRIMARY_COLOR);
+		glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND1_RGB, GL_SRC_COLOR);
+		glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE2_RGB, GL_TEXTURE);
+		glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND2_RGB, GL_SRC_COLOR);
+		glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_ALPHA, GL_MODULATE);
+		glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE0_ALPHA, GL_TEXTURE);
+		glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND0_ALPHA, GL_SRC_ALPHA);
+		glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE1_ALPHA, GL_PRIMARY_COLOR);
+		glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND1_ALPHA, GL_SRC_ALPHA);
+		for (std::size_t Group = 0; Group < myCombinedCount; ++Group)
+		{
+			const sf::Color& outlineColor = myCombined[Group].outlineColor;
+			const GLfloat Constant[4] =
+			{
+				outlineColor.r / 255.0f,
+				outlineColor.g / 255.0f,
+				outlineColor.b / 255.0f,
+				outlineColor.a / 255.0f
+			};
+			glTexEnvfv(GL_TEXTURE_ENV, GL_TEXTURE_ENV_COLOR, Constant);
+			drawPages(myCombined[Group].Pages);
+		}
+		glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	}
+	/*
+		Font only makes distance field glyphs when the program is available.
+	*/
+	const DistanceFieldProgram* Program = (0 != myDistanceFieldCount) ? DistanceFieldProgram::getProgram() : 0;
+	if (Program)
+	{
+		for (std::size_t Group = 0; Group < myDistanceFieldCount; ++Group)
+		{
+			Program->Bind(myDistanceFields[Group].outlineColor, myDistanceFields[Group].outlineWidth);
+			drawPages(myDistanceFields[Group].Pages);
+		}
+		DistanceFieldProgram::Unbind();
+	}
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+/*
+	Strings use one outline, so the group is nearly always the last one.
+*/
+sfttf::GlyphBatch::PageVertices& sfttf::GlyphBatch::getGroup(QuadGroupList& Groups, std::size_t& Count, const sf::Color& outlineColor, float outlineWidth)
+{
+	for (std::size_t Group = Count; Group > 0; --Group)
+	{
+		QuadGroup& theGroup = Groups[Group - 1];
+		if (theGroup.outlineColor == outlineColor && theGroup.outlineWidth == outlineWidth)
+			return theGroup.Pages;
+	}
+	if (Groups.size() == Count)
+		Groups.push_back(QuadGroup());
+
+	QuadGroup& newGroup = Groups[Count++];
+	newGroup.outlineColor = outlineColor;
+	newGroup.outlineWidth = outlineWidth;
+	return newGroup.Pages;
+}
+
+void sfttf::GlyphBatch::clearGroups(QuadGroupList& Groups, std::size_t& Count)
+{
+	for (std::size_t Group = 0; Group < Count; ++Group)
+	{
+		PageVertices& Pages = Groups[Group].Pages;
+		PageVertices::iterator itPage(Pages.begin());
+		const PageVertices::iterator itEnd(Pages.end());
+		for (; itEnd != itPage; ++itPage)
+			itPage->clear();
+	}
+	Count = 0;
+}
+
+void sfttf::GlyphBatch::addQuad(PageVertices& Pages, const Glyph& g, float X, float Y, float Scale, const sf::Color& Color)
+{
+	if (0 == g.textureRect.GetWidth() || 0 == g.textureRect.GetHeight())
+		return;
+
+	if (Pages.size() <= g.Page)
+		Pages.resize(g.Page + 1);
+
+	/*
+		Pages are power of two sized, so the texture is exactly the page.
+		The texture itself is not touched here: new glyphs are uploaded
+		once, when the batch is rendered.
+	*/
+	const float textureWidth = static_cast<float>(myAtlas->getPageWidth(g.Page));
+	const float textureHeight = static_cast<float>(myAtlas->getPageHeight(g.Page));
+
+	const float Left = static_cast<float>(g.textureRect.Left) / textureWidth;
+	const float Top = static_cast<float>(g.textureRect.Top) / textureHeight;
+	const float Right = static_cast<float>(g.textureRect.Right) / textureWidth;
+	const float Bottom = static_cast<float>(g.textureRect.Bottom) / textureHeight;
+	const float Width = static_cast<float>(g.textureRect.GetWidth()) * Scale;
+	const float Height = static_cast<float>(g.textureRect.GetHeight()) * Scale;
+
+	Vertex Corners[4] =
+	{
+		{X, Y, Left, Top, {Color.r, Color.g, Color.b, Color.a}},
+		{X, Y + Height, Left, Bottom, {Color.r, Color.g, Color.b, Color.a}},
+		{X + Width, Y + Height, Right, Bottom, {Color.r, Color.g, Color.b, Color.a}},
+		{X + Width, Y, Right, Top, {Color.r, Color.g, Color.b, Color.a}}
+	};
+	VertexList& Vertices = Pages[g.Page];
+	Vertices.insert(Vertices.end(), Corners, Corners + 4);
+
+	if (myEmpty)
+		myBounds = sf::FloatRect(X, Y, X + Width, Y + Height);
+	else
+	{
+		myBounds.Left = std::min(myBounds.Left, X);
+		myBounds.Top = std::min(myBounds.Top, Y);
+		myBounds.Right = std::max(myBounds.Right, X + Width);
+		myBounds.Bottom = std::max(myBounds.Bottom, Y + Height);
+	}
+	myEmpty = false;
+}
+
+/*
+	outlineColor is only given for combined glyphs, whose color is then
+	mixed from the fill and outline colors by the outline share.
+*/
+void sfttf::GlyphBatch::compositePages(const PageVertices& Pages, const sf::Color* outlineColor, sf::Uint8* Pixels, unsigned int Width, unsigned int Height, int OffsetX, int OffsetY) const
+{
+	std::vector<unsigned char> Coverage;
+	std::vector<unsigned char> outlineShare;
+	for (unsigned int Page = 0; Page < Pages.size(); ++Page)
+	{
+		const VertexList& Vertices = Pages[Page];
+		const float pageWidth = static_cast<float>(myAtlas->getPageWidth(Page));
+		const float pageHeight = static_cast<float>(myAtlas->getPageHeight(Page));
+		for (std::size_t i = 0; i + 3 < Vertices.size(); i += 4)
+		{
+			/*
+				Page sizes are powers of two, so the texture coordinates
+				convert back to the exact atlas rectangle.
+			*/
+			const Vertex& topLeft = Vertices[i];
+			const Vertex& bottomRight = Vertices[i + 2];
+			const sf::IntRect textureRect(static_cast<int>(topLeft.U * pageWidth + 0.5f),
+				static_cast<int>(topLeft.V * pageHeight + 0.5f),
+				static_cast<int>(bottomRight.U * pageWidth + 0.5f),
+				static_cast<int>(bottomRight.V * pageHeight + 0.5f));
+			const int quadWidth = textureRect.GetWidth();
+			const int quadHeight = textureRect.GetHeight();
+			Coverage.resize(quadWidth * quadHeight);
+			outlineShare.resize(Coverage.size());
+			myAtlas->Download(Page, textureRect, &Coverage[0], outlineColor ? &outlineShare[0] : 0);
+
+			const int Left = static_cast<int>(std::floor(topLeft.X + 0.5f)) + OffsetX;
+			const int Top = static_cast<int>(std::floor(topLeft.Y + 0.5f)) + OffsetY;
+			const sf::Uint8* Color = topLeft.Color;
+			for (int y = 0; y < quadHeight; ++y)
+			{
+				const int pixelY = Top + y;
+				if (pixelY < 0 || pixelY >= static_cast<int>(Height))
+					continue;
+
+				for (int x = 0; x < quadWidth; ++x)
+				{
+					const int pixelX = Left + x;
+					if (pixelX < 0 || pixelX >= static_cast<int>(Width))
+						continue;
+
+					const unsigned int sourceAlpha = Coverage[y * quadWidth + x] * Color[3] / 255;
+					if (0 == sourceAlpha)
+						continue;
+
+					sf::Uint8 sourceColor[3] = {Color[0], Color[1], Color[2]};
+					if (outlineColor)
+					{
+						const unsigned int Share = outlineShare[y * quadWidth + x];
+						sourceColor[0] = static_cast<sf::Uint8>((outlineColor->r * Share + Color[0] * (255 - Share)) / 255);
+						sourceColor[1] = static_cast<sf::Uint8>((outlineColor->g * Share + Color[1] * (255 - Share)) / 255);
+						sourceColor[2] = static_cast<sf::Uint8>((outlineColor->b * Share + Color[2] * (255 - Share)) / 255);
+					}
+
+					sf::Uint8* pDestination = &Pixels[(pixelY * Width + pixelX) * 4];
+					const unsigned int destinationAlpha = pDestination[3] * (255 - sourceAlpha) / 255;
+					const unsigned int resultAlpha = sourceAlpha + destinationAlpha;
+					for (unsigned int c = 0; c < 3; ++c)
+						pDestination[c] = static_cast<sf::Uint8>((sourceColor[c] * sourceAlpha + pDestination[c] * destinationAlpha) / resultAlpha);
+
+					pDestination[3] = static_cast<sf::Uint8>(resultAlpha);
+				}
+			}
+		}
+	}
+}
+
+void sfttf::GlyphBatch::drawPages(const PageVertices& Pages) const
+{
+	for (unsigned int Page = 0; Page < Pages.size(); ++Page)
+	{
+		const VertexList& Vertices = Pages[Page];
+		if (Vertices.empty())
+			continue;
+
+		myAtlas->Bind(Page);
+
+		const Vertex* First = &Vertices[0];
+		glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &First->X);
+		glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &First->U);
+		glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), First->Color);
+		glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(Vertices.size()));
+	}
+}
@@ -0,0 +1,84 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#include <sfttf/GlyphPool.hpp>
+#include <sfttf/Glyph.hpp>
+
+namespace
+{
+	const unsigned int firstSlabSize = 256;
+	const unsigned int maximumSlabSize = 16384;
+}
+
+sfttf::GlyphPool::GlyphPool() : myUsed(0),
+								myFreeList(0)
+{
+}
+
+sfttf::GlyphPool::~GlyphPool()
+{
+	Clear();
+}
+
+sfttf::Glyph* sfttf::GlyphPool::Allocate()
+{
+	if (myFreeList)
+	{
+		Glyph* g = myFreeList;
+		myFreeList = g->lruNext;
+		return g;
+	}
+	if (mySlabs.empty() || myUsed == mySlabs.back().Size)
+	{
+		Slab newSlab;
+		newSlab.Size = mySlabs.empty() ? firstSlabSize : mySlabs.back().Size * 2;
+		if (newSlab.Size > maximumSlabSize)
+			newSlab.Size = maximumSlabSize;
+
+		newSlab.Glyphs = new Glyph[newSlab.Size];
+		mySlabs.push_back(newSlab);
+		myUsed = 0;
+	}
+	return &mySlabs.back().Glyphs[myUsed++];
+}
+
+void sfttf::GlyphPool::Free(Glyph* g)
+{
+	g->lruNext = myFreeList;
+	myFreeList = g;
+}
+
+void sfttf::GlyphPool::Clear()
+{
+	while (!mySlabs.empty())
+	{
+		delete[] mySlabs.back().Glyphs;
+		mySlabs.pop_back();
+	}
+	myUsed = 0;
+	myFreeList = 0;
+}
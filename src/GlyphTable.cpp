@@ -0,0 +1,227 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#include <sfttf/GlyphTable.hpp>
+#include <sfttf/Atomic.hpp>
+#include <sfttf/Glyph.hpp>
+#include <sfttf/Reclaimer.hpp>
+
+namespace
+{
+	const unsigned int initialCapacity = 256;
+
+	/*
+		Marks erased entries, never handed out.
+	*/
+	sfttf::Glyph erasedGlyph;
+}
+
+sfttf::GlyphTable::GlyphTable(Reclaimer& Retired) : myRetired(&Retired),
+													myBlock(0),
+													mySize(0),
+													myUsed(0)
+{
+}
+
+sfttf::GlyphTable::~GlyphTable()
+{
+	Clear();
+}
+
+/*
+	Only reads the table, see the class comment.
+*/
+sfttf::Glyph* sfttf::GlyphTable::Find(const GlyphKey& Key) const
+{
+	const Block* theBlock = atomicLoad(myBlock);
+	if (0 == theBlock)
+		return 0;
+
+	for (unsigned int Slot = Hash(Key) & theBlock->Mask; ; Slot = (Slot + 1) & theBlock->Mask)
+	{
+		const Entry& e = theBlock->Entries[Slot];
+		Glyph* Value = atomicLoad(e.Value);
+		if (0 == Value)
+			return 0;
+
+		if (e.Key == Key)
+			return (&erasedGlyph == Value) ? 0 : Value;
+	}
+}
+
+/*
+	Erased entries are never reused for another key, so Key is found
+	(erased or not) before reaching an empty entry if it was ever added.
+*/
+void sfttf::GlyphTable::Insert(const GlyphKey& Key, Glyph* Value)
+{
+	if (0 == Value)
+		return;
+
+	if (0 == myBlock || (myUsed + 1) * 2 > myBlock->Entries.size())
+		Rebuild();
+
+	for (unsigned int Slot = Hash(Key) & myBlock->Mask; ; Slot = (Slot + 1) & myBlock->Mask)
+	{
+		Entry& e = myBlock->Entries[Slot];
+		if (0 == e.Value)
+		{
+			e.Key = Key;
+			++mySize;
+			++myUsed;
+			atomicStore(e.Value, Value);
+			return;
+		}
+		if (e.Key == Key)
+		{
+			if (&erasedGlyph == e.Value)
+				++mySize;
+
+			atomicStore(e.Value, Value);
+			return;
+		}
+	}
+}
+
+sfttf::Glyph* sfttf::GlyphTable::Erase(const GlyphKey& Key)
+{
+	if (0 == myBlock)
+		return 0;
+
+	for (unsigned int Slot = Hash(Key) & myBlock->Mask; ; Slot = (Slot + 1) & myBlock->Mask)
+	{
+		Entry& e = myBlock->Entries[Slot];
+		if (0 == e.Value)
+			return 0;
+
+		if (e.Key == Key)
+		{
+			Glyph* Result = e.Value;
+			if (&erasedGlyph == Result)
+				return 0;
+
+			atomicStore(e.Value, &erasedGlyph);
+			--mySize;
+			return Result;
+		}
+	}
+}
+
+void sfttf::GlyphTable::Clear()
+{
+	Block* oldBlock = myBlock;
+	if (0 != oldBlock)
+	{
+		atomicStore(myBlock, static_cast<Block*>(0));
+		myRetired->Retire(&GlyphTable::freeBlock, 0, oldBlock);
+	}
+	mySize = 0;
+	myUsed = 0;
+}
+
+unsigned int sfttf::GlyphTable::getSize() const
+{
+	return mySize;
+}
+
+unsigned int sfttf::GlyphTable::getCapacity() const
+{
+	return (0 == myBlock) ? 0 : static_cast<unsigned int>(myBlock->Entries.size());
+}
+
+sfttf::Glyph* sfttf::GlyphTable::getSlot(unsigned int Slot) const
+{
+	Glyph* Value = myBlock->Entries[Slot].Value;
+	return (&erasedGlyph == Value) ? 0 : Value;
+}
+
+/*
+	The code point is in the low bits, so a plain sum would put every size
+	of the same letter next to each other.
+	MurmurHash3's finalizer spreads the values over all bits.
+*/
+unsigned int sfttf::GlyphTable::Hash(const GlyphKey& Key)
+{
+	unsigned int h = Key.codePoint;
+	h ^= static_cast<unsigned int>(Key.Size) * 0x9e3779b1u;
+	h ^= static_cast<unsigned int>(Key.outlineSize) * 0x85ebca77u;
+	h ^= static_cast<unsigned int>(Key.Phase) * 0x27d4eb2fu;
+	if (Key.Combined)
+		h = ~h;
+
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35u;
+	h ^= h >> 16;
+	return h;
+}
+
+void sfttf::GlyphTable::freeBlock(void* /*Owner*/, void* Object)
+{
+	delete static_cast<Block*>(Object);
+}
+
+/*
+	Copies the live entries to a new block, filled to at most a third so
+	half as many again can be added before the next rebuild.
+	Readers still in the old block see it unchanged until it is reclaimed.
+*/
+void sfttf::GlyphTable::Rebuild()
+{
+	unsigned int newCapacity = initialCapacity;
+	while ((mySize + 1) * 3 > newCapacity)
+		newCapacity *= 2;
+
+	Entry Empty;
+	Empty.Value = 0;
+	Block* newBlock = new Block;
+	newBlock->Mask = newCapacity - 1;
+	newBlock->Entries.resize(newCapacity, Empty);
+
+	Block* oldBlock = myBlock;
+	if (0 != oldBlock)
+	{
+		EntryList::const_iterator itEntry(oldBlock->Entries.begin());
+		const EntryList::const_iterator itEnd(oldBlock->Entries.end());
+		for (; itEnd != itEntry; ++itEntry)
+		{
+			if (0 == itEntry->Value || &erasedGlyph == itEntry->Value)
+				continue;
+
+			unsigned int Slot = Hash(itEntry->Key) & newBlock->Mask;
+			while (0 != newBlock->Entries[Slot].Value)
+				Slot = (Slot + 1) & newBlock->Mask;
+
+			newBlock->Entries[Slot] = *itEntry;
+		}
+	}
+	myUsed = mySize;
+	atomicStore(myBlock, newBlock);
+	if (0 != oldBlock)
+		myRetired->Retire(&GlyphTable::freeBlock, 0, oldBlock);
+}
@@ -0,0 +1,437 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#include <sfttf/GlyphWorkers.hpp>
+#include <sfttf/FontFace.hpp>
+#include <algorithm>
+#include <SFML/System/Lock.hpp>
+#include <SFML/System/Sleep.hpp>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+namespace
+{
+	struct SignalState
+	{
+		pthread_mutex_t Mutex;
+		pthread_cond_t Condition;
+		bool Posted;
+	};
+}
+#endif
+
+sfttf::GlyphWorkers::Signal::Signal()
+{
+#ifdef _WIN32
+	myImplementation = CreateSemaphore(0, 0, 1, 0);
+#else
+	SignalState* State = new SignalState;
+	pthread_mutex_init(&State->Mutex, 0);
+	pthread_cond_init(&State->Condition, 0);
+	State->Posted = false;
+	myImplementation = State;
+#endif
+}
+
+sfttf::GlyphWorkers::Signal::~Signal()
+{
+#ifdef _WIN32
+	CloseHandle(static_cast<HANDLE>(myImplementation));
+#else
+	SignalState* State = static_cast<SignalState*>(myImplementation);
+	pthread_cond_destroy(&State->Condition);
+	pthread_mutex_destroy(&State->Mutex);
+	delete State;
+#endif
+}
+
+void sfttf::GlyphWorkers::Signal::Wait()
+{
+#ifdef _WIN32
+	WaitForSingleObject(static_cast<HANDLE>(myImplementation), INFINITE);
+#else
+	SignalState* State = static_cast<SignalState*>(myImplementation);
+	pthread_mutex_lock(&State->Mutex);
+	while (!State->Posted)
+		pthread_cond_wait(&State->Condition, &State->Mutex);
+
+	State->Posted = false;
+	pthread_mutex_unlock(&State->Mutex);
+#endif
+}
+
+/*
+	Posting twice before a Wait wakes it only once.
+*/
+void sfttf::GlyphWorkers::Signal::Post()
+{
+#ifdef _WIN32
+	ReleaseSemaphore(static_cast<HANDLE>(myImplementation), 1, 0);
+#else
+	SignalState* State = static_cast<SignalState*>(myImplementation);
+	pthread_mutex_lock(&State->Mutex);
+	State->Posted = true;
+	pthread_cond_signal(&State->Condition);
+	pthread_mutex_unlock(&State->Mutex);
+#endif
+}
+
+sfttf::GlyphWorkers::GlyphWorkers()
+{
+}
+
+sfttf::GlyphWorkers::~GlyphWorkers()
+{
+	stopWorkers(0);
+	JobQueue::iterator itQueued(myQueue.begin());
+	const JobQueue::iterator itQueueEnd(myQueue.end());
+	for (; itQueueEnd != itQueued; ++itQueued)
+		delete itQueued->Glyph;
+
+	JobList::iterator itJob(myDone.begin());
+	const JobList::iterator itEnd(myDone.end());
+	for (; itEnd != itJob; ++itJob)
+		delete itJob->Glyph;
+}
+
+/*
+	Without workers nothing would take the queued glyphs, they are
+	handed back so their faces render them themselves.
+*/
+void sfttf::GlyphWorkers::setCount(unsigned int Count)
+{
+	stopWorkers(Count);
+	while (myWorkers.size() < Count)
+	{
+		Worker* newWorker = new Worker(*this);
+		myWorkers.push_back(newWorker);
+		newWorker->Launch();
+	}
+	if (0 != Count)
+		return;
+
+	sf::Lock Lock(myMutex);
+	JobQueue::iterator itJob(myQueue.begin());
+	const JobQueue::iterator itEnd(myQueue.end());
+	for (; itEnd != itJob; ++itJob)
+		itJob->Glyph->Unstarted = true;
+
+	myDone.insert(myDone.end(), myQueue.begin(), myQueue.end());
+	myQueue.clear();
+}
+
+unsigned int sfttf::GlyphWorkers::getCount() const
+{
+	return static_cast<unsigned int>(myWorkers.size());
+}
+
+unsigned int sfttf::GlyphWorkers::getProcessorCount()
+{
+#ifdef _WIN32
+	SYSTEM_INFO Info;
+	GetSystemInfo(&Info);
+	const long Count = static_cast<long>(Info.dwNumberOfProcessors);
+#else
+	const long Count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return (Count < 1) ? 1 : static_cast<unsigned int>(Count);
+}
+
+bool sfttf::GlyphWorkers::Queue(FontFace* Face, const GlyphKey& Key)
+{
+	if (myWorkers.empty())
+		return false;
+
+	Job newJob;
+	newJob.Face = Face;
+	newJob.Glyph = new RenderedGlyph;
+	newJob.Glyph->Key = Key;
+
+	sf::Lock Lock(myMutex);
+	myQueue.push_back(newJob);
+	WorkerList::iterator itWorker(myWorkers.begin());
+	const WorkerList::iterator itEnd(myWorkers.end());
+	for (; itEnd != itWorker; ++itWorker)
+	{
+		if ((*itWorker)->Idle)
+		{
+			wakeWorker(*itWorker);
+			break;
+		}
+	}
+	return true;
+}
+
+void sfttf::GlyphWorkers::Collect(FontFace* Face, std::vector<RenderedGlyph*>& Done)
+{
+	sf::Lock Lock(myMutex);
+	JobList::iterator itKeep(myDone.begin());
+	JobList::iterator itJob(myDone.begin());
+	const JobList::iterator itEnd(myDone.end());
+	for (; itEnd != itJob; ++itJob)
+	{
+		if (Face == itJob->Face)
+			Done.push_back(itJob->Glyph);
+		else
+			*itKeep++ = *itJob;
+	}
+	myDone.erase(itKeep, itEnd);
+}
+
+void sfttf::GlyphWorkers::cancelFace(FontFace* Face)
+{
+	std::vector<RenderedGlyph*> Dropped;
+	{
+		sf::Lock Lock(myMutex);
+		takeJobs(Face, Dropped);
+	}
+	for (std::size_t i = 0; i < Dropped.size(); ++i)
+		delete Dropped[i];
+}
+
+/*
+	A worker may be rendering a glyph of Face: it throws the glyph away
+	when it sees Face in its Closing list, and empties the list once it
+	has closed its rasterizer.
+*/
+void sfttf::GlyphWorkers::removeFace(FontFace* Face)
+{
+	std::vector<RenderedGlyph*> Dropped;
+	{
+		sf::Lock Lock(myMutex);
+		takeJobs(Face, Dropped);
+
+		WorkerList::iterator itWorker(myWorkers.begin());
+		const WorkerList::iterator itWorkersEnd(myWorkers.end());
+		for (; itWorkersEnd != itWorker; ++itWorker)
+		{
+			(*itWorker)->Closing.push_back(Face);
+			wakeWorker(*itWorker);
+		}
+	}
+	for (std::size_t i = 0; i < Dropped.size(); ++i)
+		delete Dropped[i];
+
+	for (;;)
+	{
+		bool Closed = true;
+		{
+			sf::Lock Lock(myMutex);
+			WorkerList::iterator itWorker(myWorkers.begin());
+			const WorkerList::iterator itWorkersEnd(myWorkers.end());
+			for (; itWorkersEnd != itWorker; ++itWorker)
+			{
+				if (!(*itWorker)->Closing.empty())
+					Closed = false;
+			}
+		}
+		if (Closed)
+			break;
+
+		sf::Sleep(0.001f);
+	}
+}
+
+/*
+	Stops the workers after the first Keep, the others keep running.
+	A stopped worker finishes the glyph it is rendering, glyphs still
+	queued stay queued.
+*/
+void sfttf::GlyphWorkers::stopWorkers(unsigned int Keep)
+{
+	if (myWorkers.size() <= Keep)
+		return;
+
+	const WorkerList::iterator itFirst(myWorkers.begin() + Keep);
+	const WorkerList::iterator itEnd(myWorkers.end());
+	{
+		sf::Lock Lock(myMutex);
+		for (WorkerList::iterator itWorker(itFirst); itEnd != itWorker; ++itWorker)
+		{
+			(*itWorker)->Stopping = true;
+			wakeWorker(*itWorker);
+		}
+	}
+	for (WorkerList::iterator itWorker(itFirst); itEnd != itWorker; ++itWorker)
+	{
+		(*itWorker)->Wait();
+		delete *itWorker;
+	}
+	myWorkers.erase(itFirst, itEnd);
+}
+
+/*
+	Does nothing if the worker is busy, it looks for work before waiting.
+	Called with myMutex locked.
+*/
+void sfttf::GlyphWorkers::wakeWorker(Worker* Target)
+{
+	if (!Target->Idle)
+		return;
+
+	Target->Idle = false;
+	Target->Wake.Post();
+}
+
+/*
+	Moves the glyphs queued or finished for Face to Jobs.
+	Called with myMutex locked.
+*/
+void sfttf::GlyphWorkers::takeJobs(FontFace* Face, std::vector<RenderedGlyph*>& Jobs)
+{
+	JobQueue::iterator itKeep(myQueue.begin());
+	JobQueue::iterator itJob(myQueue.begin());
+	const JobQueue::iterator itEnd(myQueue.end());
+	for (; itEnd != itJob; ++itJob)
+	{
+		if (Face == itJob->Face)
+			Jobs.push_back(itJob->Glyph);
+		else
+			*itKeep++ = *itJob;
+	}
+	myQueue.erase(itKeep, itEnd);
+
+	JobList::iterator itDoneKeep(myDone.begin());
+	JobList::iterator itDone(myDone.begin());
+	const JobList::iterator itDoneEnd(myDone.end());
+	for (; itDoneEnd != itDone; ++itDone)
+	{
+		if (Face == itDone->Face)
+			Jobs.push_back(itDone->Glyph);
+		else
+			*itDoneKeep++ = *itDone;
+	}
+	myDone.erase(itDoneKeep, itDoneEnd);
+}
+
+/*
+	The face's rasterizer is only read for its face index, which does not change.
+*/
+bool sfttf::GlyphWorkers::openRasterizer(FT_Library Library, const FontFace* Face, Rasterizer& Raster)
+{
+	return 0 != Library && Raster.Open(Library, *Face->myFontFile, Face->myRasterizer.Face->face_index);
+}
+
+bool sfttf::GlyphWorkers::renderGlyph(Rasterizer& Raster, RenderedGlyph& Rendered)
+{
+	return 0 != Raster.Face && FontFace::renderGlyph(Raster, Rendered);
+}
+
+sfttf::GlyphWorkers::Worker::Worker(GlyphWorkers& Owner) : Idle(false),
+														   Stopping(false),
+														   myOwner(&Owner)
+{
+}
+
+void sfttf::GlyphWorkers::Worker::Run()
+{
+	FT_Library Library = 0;
+	if (0 != FT_Init_FreeType(&Library))
+		Library = 0;
+
+	RasterizerMap Rasterizers;
+	for (;;)
+	{
+		Job Current;
+		Current.Face = 0;
+		Current.Glyph = 0;
+		{
+			sf::Lock Lock(myOwner->myMutex);
+			closeFaces(Rasterizers);
+			if (Stopping)
+				break;
+
+			if (!myOwner->myQueue.empty())
+			{
+				Current = myOwner->myQueue.front();
+				myOwner->myQueue.pop_front();
+			}
+			else
+				Idle = true;
+		}
+		if (0 == Current.Face)
+		{
+			Wake.Wait();
+			continue;
+		}
+
+		/*
+			A face that cannot be opened keeps an empty rasterizer,
+			so it is not tried again.
+		*/
+		Rasterizer*& Raster = Rasterizers[Current.Face];
+		if (!Raster)
+		{
+			Raster = new Rasterizer;
+			openRasterizer(Library, Current.Face, *Raster);
+		}
+		Current.Glyph->Rendered = renderGlyph(*Raster, *Current.Glyph);
+
+		sf::Lock Lock(myOwner->myMutex);
+		if (Closing.end() != std::find(Closing.begin(), Closing.end(), Current.Face))
+			delete Current.Glyph;
+		else
+			myOwner->myDone.push_back(Current);
+	}
+
+	Closing.clear();
+	RasterizerMap::iterator itRasterizer(Rasterizers.begin());
+	const RasterizerMap::iterator itEnd(Rasterizers.end());
+	for (; itEnd != itRasterizer; ++itRasterizer)
+		delete itRasterizer->second;
+
+	if (0 != Library)
+		FT_Done_FreeType(Library);
+}
+
+/*
+	Called with the owner's mutex locked.
+*/
+void sfttf::GlyphWorkers::Worker::closeFaces(RasterizerMap& Rasterizers)
+{
+	std::vector<FontFace*>::iterator itFace(Closing.begin());
+	const std::vector<FontFace*>::iterator itEnd(Closing.end());
+	for (; itEnd != itFace; ++itFace)
+	{
+		const RasterizerMap::iterator itRasterizer(Rasterizers.find(*itFace));
+		if (Rasterizers.end() == itRasterizer)
+			continue;
+
+		delete itRasterizer->second;
+		Rasterizers.erase(itRasterizer);
+	}
+	Closing.clear();
+}
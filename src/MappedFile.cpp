@@ -0,0 +1,155 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#include <sfttf/MappedFile.hpp>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+sfttf::MappedFile::MappedFile() : myData(0),
+								  mySize(0)
+#ifdef _WIN32
+								  ,myFile(INVALID_HANDLE_VALUE),
+								  myMapping(0)
+#endif
+{
+}
+
+sfttf::MappedFile::~MappedFile()
+{
+	Close();
+}
+
+/*
+	Empty files cannot be mapped, they fail to open.
+*/
+#ifdef _WIN32
+bool sfttf::MappedFile::Open(const std::string& Filename)
+{
+	Close();
+	myFile = CreateFileA(Filename.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (INVALID_HANDLE_VALUE == myFile)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(myFile, &fileSize) || 0 == fileSize.QuadPart || 0 != fileSize.HighPart)
+	{
+		Close();
+		return false;
+	}
+	myMapping = CreateFileMappingA(myFile, 0, PAGE_READONLY, 0, 0, 0);
+	if (0 == myMapping)
+	{
+		Close();
+		return false;
+	}
+	myData = static_cast<const unsigned char*>(MapViewOfFile(myMapping, FILE_MAP_READ, 0, 0, 0));
+	if (0 == myData)
+	{
+		Close();
+		return false;
+	}
+	mySize = static_cast<std::size_t>(fileSize.LowPart);
+	return true;
+}
+
+void sfttf::MappedFile::Close()
+{
+	if (0 != myData)
+		UnmapViewOfFile(myData);
+
+	if (0 != myMapping)
+		CloseHandle(myMapping);
+
+	if (INVALID_HANDLE_VALUE != myFile)
+		CloseHandle(myFile);
+
+	myData = 0;
+	mySize = 0;
+	myMapping = 0;
+	myFile = INVALID_HANDLE_VALUE;
+}
+#else
+bool sfttf::MappedFile::Open(const std::string& Filename)
+{
+	Close();
+	const int File = open(Filename.c_str(), O_RDONLY);
+	if (-1 == File)
+		return false;
+
+	/*
+		The mapping stays valid after the descriptor is closed.
+	*/
+	struct stat fileStatus;
+	if (0 != fstat(File, &fileStatus) || 0 == fileStatus.st_size)
+	{
+		close(File);
+		return false;
+	}
+	void* Data = mmap(0, static_cast<std::size_t>(fileStatus.st_size), PROT_READ, MAP_SHARED, File, 0);
+	close(File);
+	if (MAP_FAILED == Data)
+		return false;
+
+	myData = static_cast<const unsigned char*>(Data);
+	mySize = static_cast<std::size_t>(fileStatus.st_size);
+	return true;
+}
+
+void sfttf::MappedFile::Close()
+{
+	if (0 != myData)
+		munmap(const_cast<unsigned char*>(myData), mySize);
+
+	myData = 0;
+	mySize = 0;
+}
+#endif
+
+bool sfttf::MappedFile::isOpen() const
+{
+	return 0 != myData;
+}
+
+const unsigned char* sfttf::MappedFile::getData() const
+{
+	return myData;
+}
+
+std::size_t sfttf::MappedFile::getSize() const
+{
+	return mySize;
+}
@@ -0,0 +1,261 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#include <sfttf/Paragraph.hpp>
+#include <algorithm>
+#include <SFML/Graphics/RenderTarget.hpp>
+
+sfttf::Paragraph::Paragraph(Font& theFont, const std::string& s, float Width, Alignment Align, float lineSpacing) : myFont(&theFont),
+																													mySettings(theFont.mySettings),
+																													myWidth(Width),
+																													myAlignment(Align),
+																													myLineSpacing(lineSpacing),
+																													myLinesDirty(true),
+																													myBatch(theFont.getAtlas()),
+																													myPlacedLines(0),
+																													myPlacedWidth(0.0f),
+																													myLayoutDirty(true),
+																													myGlyphs(theFont)
+{
+	setString(s.begin(), s.end());
+}
+
+sfttf::Paragraph::Paragraph(Font& theFont, const std::wstring& s, float Width, Alignment Align, float lineSpacing) : myFont(&theFont),
+																													 mySettings(theFont.mySettings),
+																													 myWidth(Width),
+																													 myAlignment(Align),
+																													 myLineSpacing(lineSpacing),
+																													 myLinesDirty(true),
+																													 myBatch(theFont.getAtlas()),
+																													 myPlacedLines(0),
+																													 myPlacedWidth(0.0f),
+																													 myLayoutDirty(true),
+																													 myGlyphs(theFont)
+{
+	setString(s.begin(), s.end());
+}
+
+void sfttf::Paragraph::setString(const std::string& s)
+{
+	setString(s.begin(), s.end());
+}
+
+void sfttf::Paragraph::setString(const std::wstring& s)
+{
+	setString(s.begin(), s.end());
+}
+
+void sfttf::Paragraph::setWidth(float Width)
+{
+	if (Width == myWidth)
+		return;
+
+	myWidth = Width;
+	myLinesDirty = true;
+}
+
+/*
+	Alignment and spacing do not change where lines are broken.
+*/
+void sfttf::Paragraph::setAlignment(Alignment Align)
+{
+	if (Align == myAlignment)
+		return;
+
+	myAlignment = Align;
+	myPlacedLines = 0;
+	myLayoutDirty = true;
+}
+
+void sfttf::Paragraph::setLineSpacing(float lineSpacing)
+{
+	if (lineSpacing == myLineSpacing)
+		return;
+
+	myLineSpacing = lineSpacing;
+	myPlacedLines = 0;
+	myLayoutDirty = true;
+}
+
+float sfttf::Paragraph::getWidth() const
+{
+	return myWidth;
+}
+
+sfttf::Paragraph::Alignment sfttf::Paragraph::getAlignment() const
+{
+	return myAlignment;
+}
+
+float sfttf::Paragraph::getLineSpacing() const
+{
+	return myLineSpacing;
+}
+
+/*
+	Nothing can be reused with other settings.
+*/
+void sfttf::Paragraph::updateSettings()
+{
+	mySettings = myFont->mySettings;
+	myLinesDirty = true;
+	myLayout.clear();
+}
+
+std::size_t sfttf::Paragraph::getLineCount() const
+{
+	Font::UseLock Lock(*myFont->myManager);
+	updateLines();
+	return myLines.size();
+}
+
+std::size_t sfttf::Paragraph::getLineStart(std::size_t Line) const
+{
+	Font::UseLock Lock(*myFont->myManager);
+	updateLines();
+	return (Line < myLines.size()) ? myLines[Line].Start : myText.size();
+}
+
+float sfttf::Paragraph::getHeight() const
+{
+	Font::UseLock Lock(*myFont->myManager);
+	updateLines();
+	float Ascender = 0.0f;
+	float lineAdvance = 0.0f;
+	myFont->getLineMetrics(mySettings, myLineSpacing, Ascender, lineAdvance);
+	return static_cast<float>(myLines.size()) * lineAdvance;
+}
+
+const sf::FloatRect& sfttf::Paragraph::getBounds() const
+{
+	Font::UseLock Lock(*myFont->myManager);
+	updateLayout();
+	return myBatch.getBounds();
+}
+
+void sfttf::Paragraph::Render(sf::RenderTarget& Target) const
+{
+	Font::UseLock Lock(*myFont->myManager);
+	updateLayout();
+	if (!myBatch.isEmpty())
+		Target.Draw(myBatch);
+}
+
+/*
+	Only stores the text, it is compared with the text the lines were
+	broken for when they are next needed.
+*/
+template <typename TIterator>
+void sfttf::Paragraph::setString(TIterator itCodePoint, const TIterator& itEnd)
+{
+	myText.clear();
+	for (; itEnd != itCodePoint; ++itCodePoint)
+		myText.push_back(static_cast<uint32_t>(*itCodePoint));
+}
+
+/*
+	Breaking a line only looks at the text up to the first glyph that
+	does not fit, which is in the next line's first word. So lines
+	before the one holding the first changed character, and the one
+	before it, break the same way.
+*/
+void sfttf::Paragraph::updateLines() const
+{
+	std::size_t firstLine = 0;
+	if (!myLinesDirty)
+	{
+		if (myLineText == myText)
+			return;
+
+		std::size_t Changed = 0;
+		const std::size_t commonSize = std::min(myLineText.size(), myText.size());
+		while (Changed < commonSize && myLineText[Changed] == myText[Changed])
+			++Changed;
+
+		while (firstLine + 1 < myLines.size() && myLines[firstLine + 1].Start <= Changed)
+			++firstLine;
+
+		if (0 != firstLine)
+			--firstLine;
+	}
+	myFont->breakLines(mySettings, myText, myWidth, firstLine, myLines);
+	myLineText = myText;
+	myLinesDirty = false;
+	myPlacedLines = std::min(myPlacedLines, firstLine);
+	myLayoutDirty = true;
+}
+
+/*
+	The placed glyphs are held (see Font::LayoutGlyphs). When the layout
+	is out of date anyway, every line is placed again.
+	Centered and right aligned lines move when the widest line changes
+	width if the box has none.
+*/
+void sfttf::Paragraph::updateLayout() const
+{
+	updateLines();
+	if (!myGlyphs.isCurrent())
+	{
+		myLayout.clear();
+		myPlacedLines = 0;
+		myLayoutDirty = true;
+	}
+	if (!myLayoutDirty)
+		return;
+
+	const float boxWidth = getBoxWidth();
+	if (boxWidth != myPlacedWidth && alignLeft != myAlignment)
+		myPlacedLines = 0;
+
+	float Align = 0.0f;
+	if (alignCenter == myAlignment)
+		Align = 0.5f;
+	else if (alignRight == myAlignment)
+		Align = 1.0f;
+
+	const bool Kept = (0 != myPlacedLines);
+	myGlyphs.beginLayout();
+	myFont->layoutLines(mySettings, myText, myLines, myPlacedLines, boxWidth, Align, myLineSpacing, myLayout, myBatch);
+	myGlyphs.endLayout(myLayout, Kept);
+	myPlacedLines = myLines.size();
+	myPlacedWidth = boxWidth;
+	myLayoutDirty = false;
+}
+
+float sfttf::Paragraph::getBoxWidth() const
+{
+	if (0.0f < myWidth)
+		return myWidth;
+
+	float Widest = 0.0f;
+	Font::LineList::const_iterator itLine(myLines.begin());
+	const Font::LineList::const_iterator itEnd(myLines.end());
+	for (; itEnd != itLine; ++itLine)
+		Widest = std::max(Widest, itLine->Width);
+
+	return Widest;
+}
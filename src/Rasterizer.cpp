@@ -0,0 +1,146 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#include <sfttf/Rasterizer.hpp>
+#include <sfttf/MappedFile.hpp>
+#include <cstdlib>
+#include <cstring>
+
+sfttf::Rasterizer::Rasterizer() : Face(0),
+								  Stroker(0),
+								  Size(0),
+								  outlineSize(0)
+{
+}
+
+sfttf::Rasterizer::~Rasterizer()
+{
+	Close();
+}
+
+bool sfttf::Rasterizer::Open(FT_Library Library, const MappedFile& File, long faceIndex)
+{
+	Close();
+	if (0 != FT_New_Memory_Face(Library, File.getData(), static_cast<FT_Long>(File.getSize()), faceIndex, &Face))
+	{
+		Face = 0;
+		return false;
+	}
+
+	/*
+	Only scalable Unicode fonts (I have not tested anything else)
+	*/
+	if (!Face->charmap || !FT_IS_SCALABLE(Face))
+	{
+		Close();
+		return false;
+	}
+	if (0 != FT_Stroker_New(reinterpret_cast<FT_Memory>(Library), &Stroker))
+	{
+		Stroker = 0;
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void sfttf::Rasterizer::Close()
+{
+	if (0 != Stroker)
+		FT_Stroker_Done(Stroker);
+
+	if (0 != Face)
+		FT_Done_Face(Face);
+
+	Face = 0;
+	Stroker = 0;
+	Size = 0;
+	outlineSize = 0;
+}
+
+/*
+This is the function that actually calls FT_Set_Pixel_Sizes
+*/
+bool sfttf::Rasterizer::setSize(int theSize)
+{
+	if (theSize != Size)
+	{
+		if (0 != FT_Set_Pixel_Sizes(Face, theSize, 0))
+			return false;
+
+		Size = theSize;
+	}
+	return true;
+}
+
+void sfttf::Rasterizer::setOutlineSize(int theOutlineSize)
+{
+	if (theOutlineSize != outlineSize)
+	{
+		FT_Stroker_Set(Stroker,
+			64 * theOutlineSize,
+			FT_STROKER_LINECAP_ROUND,
+			FT_STROKER_LINEJOIN_ROUND,
+			0);
+		outlineSize = theOutlineSize;
+	}
+}
+
+sfttf::RenderedGlyph::RenderedGlyph() : Rendered(false),
+										Unstarted(false),
+										Left(0),
+										Top(0),
+										xAdvanceFixed(0),
+										glyphIndex(0)
+{
+	std::memset(&Bitmap, 0, sizeof(Bitmap));
+}
+
+/*
+	Rows are copied as they are, pitch and pixel mode included
+	(GlyphAtlas::Upload converts them).
+*/
+void sfttf::RenderedGlyph::setBitmap(const FT_Bitmap& Source)
+{
+	Bitmap = Source;
+	Pixels.clear();
+	if (Source.buffer)
+		Pixels.assign(Source.buffer, Source.buffer + Source.rows * std::abs(Source.pitch));
+
+	Bitmap.buffer = Pixels.empty() ? 0 : &Pixels[0];
+}
+
+void sfttf::RenderedGlyph::setGrayBitmap(int Width, int Height)
+{
+	std::memset(&Bitmap, 0, sizeof(Bitmap));
+	Bitmap.width = Width;
+	Bitmap.rows = Height;
+	Bitmap.pitch = Width;
+	Bitmap.num_grays = 256;
+	Bitmap.pixel_mode = FT_PIXEL_MODE_GRAY;
+	Bitmap.buffer = Pixels.empty() ? 0 : &Pixels[0];
+}
@@ -0,0 +1,100 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#include <sfttf/Reclaimer.hpp>
+#include <sfttf/Atomic.hpp>
+#include <cstddef>
+
+sfttf::Reclaimer::Reclaimer() : myEpoch(0)
+{
+	myReaders[0] = 0;
+	myReaders[1] = 0;
+}
+
+sfttf::Reclaimer::~Reclaimer()
+{
+	freeAll(myRetired[1 - myEpoch]);
+	freeAll(myRetired[myEpoch]);
+}
+
+/*
+	If the epoch changed between reading it and counting ourselves in,
+	Reclaim may already have checked that epoch's count: try again in
+	the new one.
+*/
+sfttf::Reclaimer::Reader::Reader(Reclaimer& Owner) : myOwner(&Owner)
+{
+	for (;;)
+	{
+		myEpoch = atomicLoad(Owner.myEpoch);
+		atomicIncrement(Owner.myReaders[myEpoch]);
+		if (atomicLoad(Owner.myEpoch) == myEpoch)
+			break;
+
+		atomicDecrement(Owner.myReaders[myEpoch]);
+	}
+}
+
+sfttf::Reclaimer::Reader::~Reader()
+{
+	atomicDecrement(myOwner->myReaders[myEpoch]);
+}
+
+void sfttf::Reclaimer::Retire(FreeFunction Free, void* Owner, void* Object)
+{
+	Retired newRetired;
+	newRetired.Free = Free;
+	newRetired.Owner = Owner;
+	newRetired.Object = Object;
+	myRetired[myEpoch].push_back(newRetired);
+}
+
+void sfttf::Reclaimer::Reclaim()
+{
+	const long Previous = 1 - myEpoch;
+	if (0 != atomicLoad(myReaders[Previous]))
+		return;
+
+	freeAll(myRetired[Previous]);
+	if (myRetired[myEpoch].empty())
+		return;
+
+	atomicStore(myEpoch, Previous);
+	memoryBarrier();
+}
+
+/*
+	In the order retired, so an owner retired after its objects
+	is still there when they are freed.
+*/
+void sfttf::Reclaimer::freeAll(RetiredList& List)
+{
+	for (std::size_t i = 0; i < List.size(); ++i)
+		List[i].Free(List[i].Owner, List[i].Object);
+
+	List.clear();
+}
@@ -0,0 +1,187 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#include <sfttf/StringImageCache.hpp>
+
+namespace
+{
+	/*
+		Enough for a few dozen typical UI labels.
+	*/
+	const std::size_t defaultBudget = 1024 * 1024;
+
+	int compareColors(const sf::Color& Left, const sf::Color& Right)
+	{
+		if (Left.r != Right.r)
+			return Left.r < Right.r ? -1 : 1;
+
+		if (Left.g != Right.g)
+			return Left.g < Right.g ? -1 : 1;
+
+		if (Left.b != Right.b)
+			return Left.b < Right.b ? -1 : 1;
+
+		if (Left.a != Right.a)
+			return Left.a < Right.a ? -1 : 1;
+
+		return 0;
+	}
+}
+
+/*
+	Cheap fields first, the text last.
+*/
+bool sfttf::StringImageKey::operator<(const StringImageKey& Other) const
+{
+	if (Size != Other.Size)
+		return Size < Other.Size;
+
+	if (outlineSize != Other.outlineSize)
+		return outlineSize < Other.outlineSize;
+
+	if (Fill != Other.Fill)
+		return Fill < Other.Fill;
+
+	if (Outline != Other.Outline)
+		return Outline < Other.Outline;
+
+	if (Kerning != Other.Kerning)
+		return Kerning < Other.Kerning;
+
+	if (Combine != Other.Combine)
+		return Combine < Other.Combine;
+
+	if (Subpixel != Other.Subpixel)
+		return Subpixel < Other.Subpixel;
+
+	const int colorOrder = compareColors(Color, Other.Color);
+	if (0 != colorOrder)
+		return colorOrder < 0;
+
+	const int outlineColorOrder = compareColors(outlineColor, Other.outlineColor);
+	if (0 != outlineColorOrder)
+		return outlineColorOrder < 0;
+
+	return Text < Other.Text;
+}
+
+sfttf::StringImageCache::StringImageCache() : mySize(0),
+											  myBudget(defaultBudget)
+{
+}
+
+sfttf::StringImageCache::~StringImageCache()
+{
+	Clear();
+}
+
+sfttf::StringImage* sfttf::StringImageCache::Find(const StringImageKey& Key)
+{
+	ImageMap::iterator itImage(myImages.find(Key));
+	if (myImages.end() == itImage)
+		return 0;
+
+	Entry& theEntry = itImage->second;
+	if (myLru.begin() != theEntry.itLru)
+		myLru.splice(myLru.begin(), myLru, theEntry.itLru);
+
+	return theEntry.Image;
+}
+
+bool sfttf::StringImageCache::Insert(const StringImageKey& Key, StringImage* Image)
+{
+	const std::size_t imageSize = getImageMemory(Image);
+	if (0 != myBudget && imageSize > myBudget)
+	{
+		delete Image;
+		return false;
+	}
+	if (0 != myBudget)
+		trim(myBudget - imageSize);
+
+	std::pair<ImageMap::iterator, bool> Result = myImages.insert(std::make_pair(Key, Entry()));
+	Entry& theEntry = Result.first->second;
+	if (!Result.second)
+	{
+		mySize -= getImageMemory(theEntry.Image);
+		delete theEntry.Image;
+		myLru.erase(theEntry.itLru);
+	}
+	theEntry.Image = Image;
+	theEntry.itLru = myLru.insert(myLru.begin(), &Result.first->first);
+	mySize += imageSize;
+	return true;
+}
+
+void sfttf::StringImageCache::Clear()
+{
+	ImageMap::iterator itImage(myImages.begin());
+	const ImageMap::iterator itEnd(myImages.end());
+	for (; itEnd != itImage; ++itImage)
+		delete itImage->second.Image;
+
+	myImages.clear();
+	myLru.clear();
+	mySize = 0;
+}
+
+void sfttf::StringImageCache::setBudget(std::size_t Bytes)
+{
+	myBudget = Bytes;
+	if (0 != myBudget)
+		trim(myBudget);
+}
+
+std::size_t sfttf::StringImageCache::getBudget() const
+{
+	return myBudget;
+}
+
+std::size_t sfttf::StringImageCache::getSize() const
+{
+	return mySize;
+}
+
+/*
+	Evicts the least recently used images until at most Budget bytes are used.
+*/
+void sfttf::StringImageCache::trim(std::size_t Budget)
+{
+	while (mySize > Budget && !myLru.empty())
+	{
+		ImageMap::iterator itImage(myImages.find(*myLru.back()));
+		myLru.pop_back();
+		mySize -= getImageMemory(itImage->second.Image);
+		delete itImage->second.Image;
+		myImages.erase(itImage);
+	}
+}
+
+std::size_t sfttf::StringImageCache::getImageMemory(const StringImage* Image)
+{
+	return sizeof(StringImage) + Image->Image.GetWidth() * Image->Image.GetHeight() * 4;
+}
@@ -0,0 +1,104 @@
+/**********************************************************************
+Copyright (c) 2008, Daniel Wyatt (Daniel.Wyatt@gmail.com)
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions
+are met:
+
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+"AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**********************************************************************/
+#include <sfttf/TextRun.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+
+sfttf::TextRun::TextRun(Font& theFont, const std::string& s) : myFont(&theFont),
+															   mySettings(theFont.mySettings),
+															   myBatch(theFont.getAtlas()),
+															   myGlyphs(theFont),
+															   myDirty(true)
+{
+	setString(s.begin(), s.end());
+}
+
+sfttf::TextRun::TextRun(Font& theFont, const std::wstring& s) : myFont(&theFont),
+																mySettings(theFont.mySettings),
+																myBatch(theFont.getAtlas()),
+																myGlyphs(theFont),
+																myDirty(true)
+{
+	setString(s.begin(), s.end());
+}
+
+void sfttf::TextRun::setString(const std::string& s)
+{
+	setString(s.begin(), s.end());
+}
+
+void sfttf::TextRun::setString(const std::wstring& s)
+{
+	setString(s.begin(), s.end());
+}
+
+void sfttf::TextRun::updateSettings()
+{
+	mySettings = myFont->mySettings;
+	myDirty = true;
+}
+
+const sf::FloatRect& sfttf::TextRun::getBounds() const
+{
+	Font::UseLock Lock(*myFont->myManager);
+	updateLayout();
+	return myBatch.getBounds();
+}
+
+void sfttf::TextRun::Render(sf::RenderTarget& Target) const
+{
+	Font::UseLock Lock(*myFont->myManager);
+	updateLayout();
+	if (!myBatch.isEmpty())
+		Target.Draw(myBatch);
+}
+
+template <typename TIterator>
+void sfttf::TextRun::setString(TIterator itCodePoint, const TIterator& itEnd)
+{
+	myText.clear();
+	for (; itEnd != itCodePoint; ++itCodePoint)
+		myText.push_back(static_cast<uint32_t>(*itCodePoint));
+
+	myDirty = true;
+}
+
+/*
+	The run holds its glyphs (see Font::LayoutGlyphs), so evicting other
+	glyphs never makes it lay out again.
+*/
+void sfttf::TextRun::updateLayout() const
+{
+	if (!myDirty && myGlyphs.isCurrent())
+		return;
+
+	std::vector<Glyph*> Glyphs;
+	myGlyphs.beginLayout();
+	myFont->layoutRun(mySettings, myText, myBatch, &Glyphs);
+	myGlyphs.endLayout(Glyphs, false);
+	myDirty = false;
+}